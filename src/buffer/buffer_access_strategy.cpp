@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+namespace bustub {
+
+BufferAccessStrategy::Slot BufferAccessStrategy::Advance(uint32_t instance_index, size_t *slot_index) {
+  std::scoped_lock guard(latch_);
+  if (instance_index >= rings_.size()) {
+    rings_.resize(instance_index + 1);
+    next_slot_.resize(instance_index + 1, 0);
+  }
+  std::vector<Slot> &ring = rings_[instance_index];
+  if (ring.empty()) {
+    ring.resize(ring_size_);
+  }
+  *slot_index = next_slot_[instance_index];
+  next_slot_[instance_index] = (*slot_index + 1) % ring_size_;
+  return ring[*slot_index];
+}
+
+void BufferAccessStrategy::Remember(uint32_t instance_index, size_t slot_index, page_id_t page_id,
+                                    frame_id_t frame_id) {
+  std::scoped_lock guard(latch_);
+  rings_[instance_index][slot_index] = Slot{page_id, frame_id};
+}
+
+}  // namespace bustub
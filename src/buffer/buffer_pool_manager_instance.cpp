@@ -12,264 +12,1107 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
-#include "common/macros.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
 #include <utility>
+#include <vector>
+
 #include "common/logger.h"
+#include "common/macros.h"
+#include "storage/page/free_space_map_page.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, max_pool_size) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t max_pool_size)
     : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
       num_instances_(num_instances),
       instance_index_(instance_index),
       next_page_id_(instance_index),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      arena_(max_pool_size_),
+      io_in_progress_(max_pool_size_, false),
+      write_backs_in_flight_(max_pool_size_, 0),
+      io_done_(new std::condition_variable[max_pool_size_]) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // Frame data lives in the arena; the frame book-keeping gets an array of its own, aligned to cache lines.
+  pages_ = static_cast<Page *>(::operator new[](max_pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (&pages_[i]) Page(arena_.GetFrameData(static_cast<frame_id_t>(i)));
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
 
-  // Initially, every page is in the free list.
+  // Initially, every page in use is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+  last_access_.resize(max_pool_size_, 0);
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+  StopResidentPageDumps();
+  read_ahead_worker_.reset();
+  StopBackgroundFlusher();
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t{alignof(Page)});
   delete replacer_;
 }
 
-// size_t BufferPoolManagerInstance::findPage(page_id_t page_id) {
-//   for (size_t i = 0; i < pool_size_; i++) {
-//     if (pages_->GetPageId() == page_id) {
-//       return i; 
-//     }
-//   }
-//   return -1;
-// }
+void BufferPoolManagerInstance::RunBackgroundFlusher(size_t dirty_high_water, size_t max_writes_per_second) {
+  std::scoped_lock lock(latch_);
+  if (flusher_running_) {
+    return;
+  }
+  dirty_high_water_ = dirty_high_water;
+  max_writes_per_second_ = max_writes_per_second;
+  flusher_running_ = true;
+  flusher_thread_ = std::thread(&BufferPoolManagerInstance::BackgroundFlush, this);
+}
 
-bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
-  // Make sure you call DiskManager::WritePage!
-  //TODO
-  // std::lock_guard<std::mutex> lk(latch_);
-  // size_t idx = findPage(page_id);
-  // if (idx == -1)
-  //   return false;
-  frame_id_t idx;
-  if (page_table_.find(page_id) != page_table_.end()) {
-    idx = page_table_[page_id];
+void BufferPoolManagerInstance::StopBackgroundFlusher() {
+  {
+    std::scoped_lock lock(latch_);
+    flusher_running_ = false;
+  }
+  flusher_cv_.notify_all();
+  if (flusher_thread_.joinable()) {
+    flusher_thread_.join();
+  }
+}
+
+void BufferPoolManagerInstance::BackgroundFlush() {
+  // Writes go out a batch at a time, from copies of the pages, so that the flusher keeps dozens of writes in flight
+  // but holds no more than one page latch at a time.
+  std::unique_ptr<AsyncIo> io = disk_manager_->CreateAsyncIo(ASYNC_IO_QUEUE_DEPTH);
+  const size_t batch_size = io->GetQueueDepth();
+  // A FrameArena, so that the copies are aligned for direct I/O.
+  FrameArena staging(batch_size);
+  io->RegisterBuffers(staging.GetFrameData(0), batch_size * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, frame_id_t>> batch;
+  std::vector<IoCompletion> completions;
+
+  std::unique_lock lock(latch_);
+  while (flusher_running_) {
+    flusher_cv_.wait_for(lock, background_flush_interval,
+                         [this] { return !flusher_running_ || num_dirty_ > dirty_high_water_; });
+    const size_t low_water = dirty_high_water_ / 2;
+    if (!flusher_running_ || num_dirty_ <= low_water) {
+      continue;
+    }
+
+    // Write in page id order, so that the disk sees runs of ascending offsets.
+    std::vector<page_id_t> candidates;
+    for (const auto &entry : page_table_) {
+      const Page &page = pages_[entry.second];
+      if (page.is_dirty_ && page.pin_count_ == 0 && !io_in_progress_[entry.second]) {
+        candidates.push_back(entry.first);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t num_written = 0;
+    for (size_t next = 0; flusher_running_;) {
+      // Pin and mark clean the next pages that are still dirty and unpinned, as WritePageBack does for one.
+      batch.clear();
+      for (; next < candidates.size() && batch.size() < batch_size && num_dirty_ > low_water; next++) {
+        auto it = page_table_.find(candidates[next]);
+        if (it == page_table_.end() || io_in_progress_[it->second]) {
+          continue;
+        }
+        Page *page = &pages_[it->second];
+        if (!page->is_dirty_ || page->pin_count_ > 0) {
+          continue;
+        }
+        StartWriteBack(it->second);
+        batch.emplace_back(*it);
+      }
+      if (batch.empty()) {
+        break;
+      }
+      lock.unlock();
+
+      for (size_t i = 0; i < batch.size(); i++) {
+        Page *page = &pages_[batch[i].second];
+        char *copy = staging.GetFrameData(static_cast<frame_id_t>(i));
+        page->RLatch();
+        memcpy(copy, page->GetData(), PAGE_SIZE);
+        page->RUnlatch();
+        io->QueueWrite(batch[i].first, copy, i);
+      }
+      io->Submit();
+      completions.clear();
+      io->Reap(&completions, batch.size());
+
+      lock.lock();
+      for (const IoCompletion &completion : completions) {
+        if (!completion.ok_) {
+          // The page is still only in memory; it gets written another time.
+          SetDirty(&pages_[batch[completion.tag_].second], true);
+        }
+      }
+      for (const auto &[page_id, frame_id] : batch) {
+        FinishWriteBack(frame_id);
+      }
+      num_written += batch.size();
+      if (max_writes_per_second_ > 0) {
+        const auto next_write = start + std::chrono::microseconds(num_written * 1000000 / max_writes_per_second_);
+        flusher_cv_.wait_until(lock, next_write, [this] { return !flusher_running_; });
+      }
+    }
+    if (num_written == 0) {
+      // Everything dirty is pinned. Back off for a full interval rather than spin on the high-water mark.
+      flusher_cv_.wait_for(lock, background_flush_interval, [this] { return !flusher_running_; });
+    }
+  }
+}
+
+void BufferPoolManagerInstance::SetDirty(Page *page, bool is_dirty) {
+  if (page->is_dirty_ == is_dirty) {
+    return;
+  }
+  page->is_dirty_ = is_dirty;
+  if (is_dirty) {
+    num_dirty_++;
+    if (flusher_running_ && num_dirty_ == dirty_high_water_ + 1) {
+      flusher_cv_.notify_one();
+    }
   } else {
-    return false;
+    num_dirty_--;
   }
-  pages_[idx].WLatch();
-  disk_manager_->WritePage(page_id, pages_[idx].GetData());
-  pages_[idx].WUnlatch();
-  return true;
-  
 }
 
-void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  // std::lock_guard<std::mutex> lk(latch_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    pages_[i].WLatch();
-    disk_manager_->WritePage(pages_[i].GetPageId(), pages_[i].GetData());
-    pages_[i].WUnlatch();
-  }
-}
-
-void BufferPoolManagerInstance::InitPage(frame_id_t frame_id, page_id_t page_id) {
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].pin_count_ = 0;
-
-}
-
-Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
-  // 0.   Make sure you call AllocatePage!
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-
-  //TODO
-  std::lock_guard<std::mutex> lk(latch_);
-  // bool flag = false;
-  // for (int i = 0; i < pool_size_; i++) {
-  //   if(pages_[i].GetPinCount() == 0) {
-  //     flag = true;
-  //   }
-  // }
-
-  // if (flag == false) {
-  //   return nullptr;
-  // }
-  if(free_list_.empty() && replacer_->Size()== 0) {
-    return nullptr;
+void BufferPoolManagerInstance::FinishFrameIo(frame_id_t frame_id) {
+  io_in_progress_[frame_id] = false;
+  io_done_[frame_id].notify_all();
+  if (IsRetiring(frame_id)) {
+    resize_cv_.notify_all();
   }
+}
 
-  auto pid = AllocatePage();
-  *page_id = pid;
-  frame_id_t frame_id = -1;
+void BufferPoolManagerInstance::StartWriteBack(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page->pin_count_++;
+  if (page->is_dirty_) {
+    SetDirty(page, false);
+    counters_.Add(BufferPoolCounters::DIRTY_WRITE_BACKS);
+  }
+  write_backs_in_flight_[frame_id]++;
+}
 
-    //从free list中找可以使用的frame
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-    page_table_[*page_id] = frame_id;
-    InitPage(frame_id, *page_id);
-    pages_[frame_id].pin_count_++;
-    replacer_->Pin(frame_id);
-    return &pages_[frame_id];
+void BufferPoolManagerInstance::FinishWriteBack(frame_id_t frame_id) {
+  if (--write_backs_in_flight_[frame_id] == 0) {
+    io_done_[frame_id].notify_all();
+  }
+  if (--pages_[frame_id].pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
   }
+}
+
+void BufferPoolManagerInstance::WaitForLatch(std::unique_lock<std::mutex> *lock) {
+  // Only a contended latch pays for reading the clock.
+  const auto start = std::chrono::steady_clock::now();
+  lock->lock();
+  const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  counters_.Add(BufferPoolCounters::LATCH_WAIT_NS, waited.count());
+}
+
+void BufferPoolManagerInstance::SamplePinnedFrames() {
+  const size_t num_pinned = pool_size_ - std::min<size_t>(pool_size_, free_list_.size() + replacer_->Size());
+  pinned_frames_high_water_ = std::max(pinned_frames_high_water_, num_pinned);
+}
 
-  //从LRU中找可以使用的frame
-  if (replacer_->Size()) {
-    bool res = replacer_->Victim(&frame_id);
-    if (res) {
-      auto evit_pid = pages_[frame_id].GetPageId();
+void BufferPoolManagerInstance::EnableCompressedCache(size_t capacity) {
+  compressed_cache_ = capacity == 0 ? nullptr : std::make_unique<CompressedPageCache>(capacity);
+}
 
+BufferPoolMetrics BufferPoolManagerInstance::GetMetrics() {
+  BufferPoolMetrics metrics = counters_.Snapshot();
+  std::scoped_lock lock(latch_);
+  SamplePinnedFrames();
+  metrics.pinned_frames_high_water_ = pinned_frames_high_water_;
+  return metrics;
+}
+
+bool BufferPoolManagerInstance::IsPageDirty(page_id_t page_id) {
+  std::unique_lock lock(latch_);
+  frame_id_t frame_id;
+  return FindResidentFrame(&lock, page_id, &frame_id) &&
+         (pages_[frame_id].is_dirty_ || write_backs_in_flight_[frame_id] > 0);
+}
 
-      if (pages_[frame_id].IsDirty()) {
-        bool res = FlushPgImp(pages_[frame_id].GetPageId());
-        if (!res) {
-          LOG_WARN("把脏页刷新到磁盘失败");
+bool BufferPoolManagerInstance::RetireFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  while (true) {
+    if (page->page_id_ == INVALID_PAGE_ID) {
+      // Free, and out of the free list already.
+      return true;
+    }
+    if (page->pin_count_ > 0 || io_in_progress_[frame_id]) {
+      return false;
+    }
+    if (page->is_dirty_) {
+      // The latch is released during the write, so look at the frame again afterwards.
+      WritePageBack(lock, page->page_id_, true);
+      continue;
+    }
+    // Out of the replacer without counting as an access, which would skew LRU-K's history.
+    replacer_->Evict(frame_id);
+    page_table_.erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    counters_.Add(BufferPoolCounters::EVICTIONS);
+    return true;
+  }
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size) {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::scoped_lock resize_lock(resize_latch_);
+  std::unique_lock lock(latch_);
+  const size_t old_pool_size = pool_size_;
+  pool_size_ = pool_size;
+  if (pool_size >= old_pool_size) {
+    for (size_t i = old_pool_size; i < pool_size; ++i) {
+      free_list_.emplace_back(static_cast<frame_id_t>(i));
+    }
+    return true;
+  }
+
+  // From now on no frame above pool_size is handed out: AcquireFrame retires those it finds in the replacer.
+  free_list_.remove_if([this](frame_id_t frame_id) { return IsRetiring(frame_id); });
+  for (size_t i = pool_size; i < old_pool_size; ++i) {
+    while (!RetireFrame(&lock, static_cast<frame_id_t>(i))) {
+      resize_cv_.wait_for(lock, resize_retry_interval);
+    }
+  }
+  lock.unlock();
+  if (!frames_registered_) {
+    // Registered frames stay pinned to the pages the kernel knows; letting them go would leave reads landing there.
+    arena_.ReleaseFrom(static_cast<frame_id_t>(pool_size));
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FindResidentFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id,
+                                                  frame_id_t *frame_id) {
+  while (true) {
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) {
+      return false;
+    }
+    if (!io_in_progress_[it->second]) {
+      *frame_id = it->second;
+      return true;
+    }
+    // The frame may hold a different page, or none, once the I/O is done, so look the page up again.
+    io_done_[it->second].wait(*lock);
+  }
+}
+
+bool BufferPoolManagerInstance::TakeRingFrame(BufferAccessStrategy *strategy, size_t *ring_slot, bool write_back_dirty,
+                                              frame_id_t *frame_id) {
+  BufferAccessStrategy::Slot slot = strategy->Advance(instance_index_, ring_slot);
+  if (slot.page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+  // The frame may be recycled only if it still holds the page the ring put there and is not pinned, by the operation
+  // itself or anybody else. Evict fails if it is pinned or still in the middle of I/O. A dirty frame that is not to be
+  // written back is left alone before Evict, which would lose its place in the replacer.
+  auto it = page_table_.find(slot.page_id_);
+  if (it == page_table_.end() || it->second != slot.frame_id_ || pages_[slot.frame_id_].pin_count_ > 0 ||
+      (!write_back_dirty && pages_[slot.frame_id_].is_dirty_) || !replacer_->Evict(slot.frame_id_)) {
+    return false;
+  }
+  *frame_id = slot.frame_id_;
+  return true;
+}
+
+bool BufferPoolManagerInstance::AcquireFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id,
+                                             bool write_back_dirty, BufferAccessStrategy *strategy,
+                                             size_t *ring_slot) {
+  SamplePinnedFrames();
+  bool try_ring = strategy != nullptr;
+  while (true) {
+    frame_id_t victim;
+    // A page a bulk operation is done with is not worth keeping in the compressed cache either. Nor is one evicted
+    // without write-back: the latch stays held then, and compressing under it would stall every other request.
+    bool keep_compressed = compressed_cache_ != nullptr && write_back_dirty;
+    if (try_ring && TakeRingFrame(strategy, ring_slot, write_back_dirty, &victim)) {
+      // Recycle the ring's own frame instead of evicting somebody else's page.
+      keep_compressed = false;
+    } else {
+      if (!free_list_.empty()) {
+        *frame_id = free_list_.front();
+        free_list_.pop_front();
+        return true;
+      }
+      // Without write-back, dirty frames are passed over where they stand: taking one out of the replacer and putting
+      // it back would count as an access and lose its place.
+      const auto clean = [this](frame_id_t frame) { return !pages_[frame].is_dirty_; };
+      if (!(write_back_dirty ? replacer_->Victim(&victim) : replacer_->Victim(&victim, clean))) {
+        counters_.Add(BufferPoolCounters::VICTIM_FAILURES);
+        return false;
+      }
+    }
+    try_ring = false;
+    Page *page = &pages_[victim];
+    if (page->pin_count_ > 0) {
+      // Pinned by a flush since it was last unpinned; the flush puts it back into the replacer when it is done.
+      continue;
+    }
+    if (page->is_dirty_ || keep_compressed) {
+      const bool write_back = page->is_dirty_;
+      if (write_back) {
+        SetDirty(page, false);
+        counters_.Add(BufferPoolCounters::DIRTY_WRITE_BACKS);
+      }
+      io_in_progress_[victim] = true;
+      lock->unlock();
+      if (write_back) {
+        disk_manager_->WritePage(page->page_id_, page->GetData());
+      }
+      if (keep_compressed) {
+        compressed_cache_->Insert(page->page_id_, page->GetData());
+      }
+      lock->lock();
+      FinishFrameIo(victim);
+      if (page->pin_count_ > 0 || page->is_dirty_) {
+        // Somebody fetched the old page while it was being written back, so the frame is in use again.
+        if (keep_compressed) {
+          compressed_cache_->Erase(page->page_id_);
         }
+        continue;
       }
-      page_table_.erase(evit_pid);
-      page_table_[*page_id] = frame_id;
-      InitPage(frame_id, *page_id);
-      pages_[frame_id].pin_count_++;
-      replacer_->Pin(frame_id);
-      return &pages_[frame_id];
-    } else {
-      LOG_WARN("replacer中没有找到可以去除的frame");
     }
+    page_table_.erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    counters_.Add(BufferPoolCounters::EVICTIONS);
+    if (IsRetiring(victim)) {
+      // Left over from a shrink; the Resize waiting for it finds it free now.
+      resize_cv_.notify_all();
+      continue;
+    }
+    *frame_id = victim;
+    return true;
   }
-  return nullptr;
 }
 
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  // 2.     If R is dirty, write it back to the disk.
-  // 3.     Delete R from the page table and insert P.
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  
-  //TODO 上层应用请求page
-  std::lock_guard<std::mutex> lk(latch_);
-  if (page_table_.find(page_id)!=page_table_.end()) {
-    frame_id_t idx = page_table_[page_id];
-    pages_[idx].pin_count_++;
-    return &pages_[idx];
+bool BufferPoolManagerInstance::WritePageBack(std::unique_lock<std::mutex> *lock, page_id_t page_id,
+                                              bool only_dirty_unpinned) {
+  frame_id_t frame_id;
+  if (!FindResidentFrame(lock, page_id, &frame_id)) {
+    return false;
   }
+  Page *page = &pages_[frame_id];
+  if (only_dirty_unpinned && (!page->is_dirty_ || page->pin_count_ > 0)) {
+    return false;
+  }
+  StartWriteBack(frame_id);
+  lock->unlock();
 
-    //从free list中找可以使用的frame
-  if (!free_list_.empty()) {
-    auto frame_id = free_list_.front();
-    free_list_.pop_front();
-    page_table_[page_id] = frame_id;
-    InitPage(frame_id, page_id);
-    pages_[frame_id].pin_count_++;
-    //从磁盘中读取数据
-    disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
-    return &pages_[frame_id];
-  }
-
-  //从LRU中找可以使用的frame
-  if (replacer_->Size()) {
-    frame_id_t frame_id = -1;
-    bool res = replacer_->Victim(&frame_id);
-    if (res) {
-      if (pages_[frame_id].IsDirty()) {
-        bool res = FlushPgImp(pages_[frame_id].GetPageId());
-        if (!res) {
-          LOG_WARN("把脏页刷新到磁盘失败");
-        }
+  page->RLatch();
+  disk_manager_->WritePage(page_id, page->GetData());
+  page->RUnlatch();
+
+  lock->lock();
+  FinishWriteBack(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
+  auto lock = LockLatch();
+  return WritePageBack(&lock, page_id, false);
+}
+
+void BufferPoolManagerInstance::FlushAllPgsImp() {
+  // Pin every dirty page, as WritePageBack does, and mark it clean up front: a page modified during the flush is
+  // dirty again afterwards.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  bool waited_for_write = false;
+  {
+    std::unique_lock lock(latch_);
+    // The write-backs already under way, of a victim, by FlushPage, by the background flusher or by another flush, have
+    // marked their pages clean, and have to land before the sync below: wait for them, and look again after each wait,
+    // as the latch is released meanwhile. A frame being read into is pinned, and is not waited for; the caller may hold
+    // a prefetch it has yet to submit.
+    const auto busy = [this](frame_id_t frame_id) {
+      return (io_in_progress_[frame_id] && pages_[frame_id].pin_count_ == 0) || write_backs_in_flight_[frame_id] > 0;
+    };
+    while (true) {
+      auto it = std::find_if(page_table_.begin(), page_table_.end(),
+                             [&busy](const auto &entry) { return busy(entry.second); });
+      if (it == page_table_.end()) {
+        break;
+      }
+      const frame_id_t frame_id = it->second;
+      io_done_[frame_id].wait(lock, [&busy, frame_id] { return !busy(frame_id); });
+      waited_for_write = true;
+    }
+    for (const auto &entry : page_table_) {
+      if (pages_[entry.second].is_dirty_) {
+        StartWriteBack(entry.second);
+        dirty_pages.emplace_back(entry);
       }
-      auto evit_pid = pages_[frame_id].GetPageId();
+    }
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+
+  // Write the pages a batch at a time, each run of consecutive page ids with one vectored write. A page is latched only
+  // while it is copied into the batch, not for the write itself, so the flush never holds more than one page latch at
+  // a time.
+  std::vector<char> batch_buffer(std::min(dirty_pages.size(), FLUSH_MAX_BATCH_PAGES) * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  for (size_t begin = 0; begin < dirty_pages.size(); begin += FLUSH_MAX_BATCH_PAGES) {
+    const size_t end = std::min(begin + FLUSH_MAX_BATCH_PAGES, dirty_pages.size());
+    batch.clear();
+    for (size_t i = begin; i < end; i++) {
+      Page *page = &pages_[dirty_pages[i].second];
+      char *copy = &batch_buffer[(i - begin) * PAGE_SIZE];
+      page->RLatch();
+      memcpy(copy, page->GetData(), PAGE_SIZE);
+      page->RUnlatch();
+      batch.emplace_back(dirty_pages[i].first, copy);
+    }
+    disk_manager_->WritePageBatch(batch.data(), batch.size(), false);
+  }
+  if (!dirty_pages.empty() || waited_for_write) {
+    disk_manager_->Sync();
+  }
+
+  std::scoped_lock lock(latch_);
+  for (const auto &[page_id, frame_id] : dirty_pages) {
+    FinishWriteBack(frame_id);
+  }
+}
 
-      page_table_.erase(evit_pid);
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) { return NewPgImp(page_id, nullptr); }
 
-      page_table_[page_id] = frame_id;
-      InitPage(frame_id, page_id);
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  return NewPgImp(page_id, strategy, ANY_DATA_FILE);
+}
+
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy,
+                                          data_file_id_t data_file) {
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  size_t ring_slot;
+  if (!AcquireFrame(&lock, &frame_id, true, strategy, &ring_slot)) {
+    return nullptr;
+  }
+
+  const size_t num_free = free_page_map_.NumFree();
+  *page_id = AllocatePage(data_file);
+  // Pages skipped for the sake of data_file add to the map, so it only shrinks if the page came out of it.
+  const bool reused = free_page_map_.NumFree() < num_free;
+  Page *page = &pages_[frame_id];
+  page->ResetMemory();
+  page->page_id_ = *page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = false;
+  if (reused) {
+    // Whatever the page held before it was deallocated is still on disk; make sure it gets overwritten.
+    SetDirty(page, true);
+  }
+  page_table_[*page_id] = frame_id;
+  replacer_->Pin(frame_id);
+  RecordAccess(frame_id);
+  counters_.Add(BufferPoolCounters::NEW_PAGES);
+  if (strategy != nullptr) {
+    strategy->Remember(instance_index_, ring_slot, *page_id, frame_id);
+  }
+  if (reused) {
+    lock.unlock();
+    SaveFreePageMapSlot(static_cast<size_t>(*page_id) / num_instances_);
+  }
+  return page;
+}
+
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchPgImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  auto lock = LockLatch();
+  while (true) {
+    frame_id_t frame_id;
+    if (FindResidentFrame(&lock, page_id, &frame_id)) {
       pages_[frame_id].pin_count_++;
       replacer_->Pin(frame_id);
-      disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+      RecordAccess(frame_id);
+      counters_.Add(BufferPoolCounters::FETCH_HITS);
       return &pages_[frame_id];
+    }
+
+    size_t ring_slot;
+    if (!AcquireFrame(&lock, &frame_id, true, strategy, &ring_slot)) {
+      return nullptr;
+    }
+    if (page_table_.find(page_id) != page_table_.end()) {
+      // Another requester brought the page in while we were writing back a victim; use theirs. The frame goes back to
+      // the free list, unless a shrink has retired it meanwhile.
+      if (IsRetiring(frame_id)) {
+        resize_cv_.notify_all();
+      } else {
+        free_list_.push_front(frame_id);
+      }
+      continue;
+    }
+
+    // Publish the frame as "in I/O" before dropping the latch, so concurrent requesters of this page wait for it and
+    // everybody else carries on.
+    Page *page = &pages_[frame_id];
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    page->is_dirty_ = false;
+    page_table_[page_id] = frame_id;
+    replacer_->Pin(frame_id);
+    RecordAccess(frame_id);
+    counters_.Add(BufferPoolCounters::FETCH_MISSES);
+    io_in_progress_[frame_id] = true;
+    if (strategy != nullptr) {
+      strategy->Remember(instance_index_, ring_slot, page_id, frame_id);
+    }
+    lock.unlock();
+
+    const bool cached = compressed_cache_ != nullptr && compressed_cache_->Take(page_id, page->GetData());
+    if (!cached) {
+      disk_manager_->ReadPage(page_id, page->GetData());
+    }
+
+    lock.lock();
+    FinishFrameIo(frame_id);
+    if (cached) {
+      counters_.Add(BufferPoolCounters::COMPRESSED_CACHE_HITS);
+    }
+    return page;
+  }
+}
+
+std::shared_ptr<ReadAheadRequest> BufferPoolManagerInstance::ReadAhead(page_id_t first_page_id, size_t num_pages,
+                                                                     next_page_fn next_page,
+                                                                     std::shared_ptr<BufferAccessStrategy> strategy) {
+  std::call_once(read_ahead_worker_created_, [this] {
+    std::unique_ptr<AsyncIo> io = disk_manager_->CreateAsyncIo(ASYNC_IO_QUEUE_DEPTH);
+    if (register_frames_for_read_ahead_) {
+      std::scoped_lock resize_lock(resize_latch_);
+      frames_registered_ = io->RegisterBuffers(arena_.GetFrameData(0), arena_.GetSize());
+    }
+    read_ahead_worker_ = std::make_unique<ReadAheadWorker>(this, std::move(io));
+  });
+  return read_ahead_worker_->Submit(first_page_id, num_pages, next_page, std::move(strategy));
+}
+
+bool BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                                              BufferAccessStrategy *strategy) {
+  return StartPrefetchPgImp(page_id, next_page, next_page_id, nullptr, 0, strategy) == PrefetchStatus::DONE;
+}
+
+BufferPoolManager::PrefetchStatus BufferPoolManagerInstance::StartPrefetchPgImp(page_id_t page_id,
+                                                                                next_page_fn next_page,
+                                                                                page_id_t *next_page_id, AsyncIo *io,
+                                                                                uint64_t tag,
+                                                                                BufferAccessStrategy *strategy) {
+  std::unique_lock lock(latch_);
+  auto it = page_table_.find(page_id);
+  if (it != page_table_.end() && io_in_progress_[it->second]) {
+    return PrefetchStatus::IN_PROGRESS;
+  }
+  frame_id_t frame_id;
+  if (FindResidentFrame(&lock, page_id, &frame_id)) {
+    // Already resident, so only its successor is needed. Pin it without telling the replacer: this is not an access.
+    Page *page = &pages_[frame_id];
+    page->pin_count_++;
+    lock.unlock();
+    page->RLatch();
+    *next_page_id = next_page(page->GetData());
+    page->RUnlatch();
+    lock.lock();
+    if (--page->pin_count_ == 0) {
+      replacer_->Unpin(frame_id);
+    }
+    return PrefetchStatus::DONE;
+  }
+
+  // Without write-back, AcquireFrame keeps the latch held, so nobody can have loaded the page in the meantime.
+  size_t ring_slot;
+  if (!AcquireFrame(&lock, &frame_id, false, strategy, &ring_slot)) {
+    return PrefetchStatus::FAILED;
+  }
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = false;
+  page_table_[page_id] = frame_id;
+  io_in_progress_[frame_id] = true;
+  if (strategy != nullptr) {
+    strategy->Remember(instance_index_, ring_slot, page_id, frame_id);
+  }
+  lock.unlock();
+
+  if (compressed_cache_ == nullptr || !compressed_cache_->Take(page_id, page->GetData())) {
+    if (io != nullptr) {
+      io->QueueRead(page_id, page->GetData(), tag);
+      return PrefetchStatus::QUEUED;
+    }
+    disk_manager_->ReadPage(page_id, page->GetData());
+  }
+  FinishPrefetch(frame_id, next_page, next_page_id, true);
+  return PrefetchStatus::DONE;
+}
+
+void BufferPoolManagerInstance::FinishPrefetchPgImp(page_id_t page_id, next_page_fn next_page,
+                                                    page_id_t *next_page_id, bool ok) {
+  frame_id_t frame_id;
+  {
+    // The frame is in I/O, so the page cannot have gone anywhere.
+    std::scoped_lock lock(latch_);
+    auto it = page_table_.find(page_id);
+    BUSTUB_ASSERT(it != page_table_.end() && io_in_progress_[it->second], "no prefetch of this page in progress");
+    frame_id = it->second;
+  }
+  FinishPrefetch(frame_id, next_page, next_page_id, ok);
+}
+
+void BufferPoolManagerInstance::FinishPrefetch(frame_id_t frame_id, next_page_fn next_page, page_id_t *next_page_id,
+                                               bool ok) {
+  Page *page = &pages_[frame_id];
+  *next_page_id = ok ? next_page(page->GetData()) : INVALID_PAGE_ID;
+
+  std::scoped_lock lock(latch_);
+  FinishFrameIo(frame_id);
+  if (!ok) {
+    // Nobody has seen the page yet; whoever waited for it reads it themselves.
+    page_table_.erase(page->page_id_);
+    page->page_id_ = INVALID_PAGE_ID;
+    page->pin_count_ = 0;
+    if (IsRetiring(frame_id)) {
+      resize_cv_.notify_all();
     } else {
-      LOG_WARN("replacer中没有找到可以去除的frame");
+      free_list_.push_back(frame_id);
     }
+    return;
+  }
+  // The page enters the replacer as if it had just been unpinned after a single access.
+  if (--page->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
   }
-  LOG_WARN("没有找到可以使用的frame");
-  return nullptr;
 }
 
-bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
-  // 0.   Make sure you call DeallocatePage!
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  //TODO
-  std::lock_guard<std::mutex> lk(latch_);
-  DeallocatePage(page_id);
-  if (page_table_.find(page_id) == page_table_.end()) {
-    return true;
-  } else {
-    frame_id_t idx = page_table_[page_id];
-    if (pages_[idx].GetPinCount() != 0) {
+bool BufferPoolManagerInstance::DumpResidentPages(const std::string &file_name) {
+  std::vector<std::pair<uint64_t, page_id_t>> resident;
+  {
+    std::scoped_lock lock(latch_);
+    resident.reserve(page_table_.size());
+    for (const auto &[page_id, frame_id] : page_table_) {
+      if (!io_in_progress_[frame_id]) {
+        resident.emplace_back(last_access_[frame_id], page_id);
+      }
+    }
+  }
+  std::sort(resident.begin(), resident.end(), std::greater<>());
+
+  const std::string tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    const auto num_pages = static_cast<uint32_t>(resident.size());
+    out.write(reinterpret_cast<const char *>(&RESIDENT_PAGES_MAGIC), sizeof(RESIDENT_PAGES_MAGIC));
+    out.write(reinterpret_cast<const char *>(&num_pages), sizeof(num_pages));
+    for (const auto &entry : resident) {
+      out.write(reinterpret_cast<const char *>(&entry.second), sizeof(page_id_t));
+    }
+    out.flush();
+    if (!out) {
+      LOG_DEBUG("I/O error while dumping resident pages");
       return false;
-    } else {
-      if (pages_[idx].IsDirty()) {
-        bool res = FlushPgImp(pages_[idx].GetPageId());
-        if (!res) {
-          LOG_WARN("把脏页刷新到磁盘失败");
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+void BufferPoolManagerInstance::RunResidentPageDumps(const std::string &file_name,
+                                                     std::chrono::milliseconds interval) {
+  std::scoped_lock lock(latch_);
+  if (dump_running_) {
+    return;
+  }
+  dump_running_ = true;
+  dump_thread_ = std::thread([this, file_name, interval] {
+    std::unique_lock lock(latch_);
+    // Dump once more after being stopped, so that the file reflects the pool as it was at shutdown.
+    for (bool running = true; running;) {
+      dump_cv_.wait_for(lock, interval, [this] { return !dump_running_; });
+      running = dump_running_;
+      lock.unlock();
+      DumpResidentPages(file_name);
+      lock.lock();
+    }
+  });
+}
+
+void BufferPoolManagerInstance::StopResidentPageDumps() {
+  {
+    std::scoped_lock lock(latch_);
+    dump_running_ = false;
+  }
+  dump_cv_.notify_all();
+  if (dump_thread_.joinable()) {
+    dump_thread_.join();
+  }
+}
+
+size_t BufferPoolManagerInstance::WarmUp(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  uint32_t magic = 0;
+  uint32_t num_pages = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&num_pages), sizeof(num_pages));
+  if (!in || magic != RESIDENT_PAGES_MAGIC) {
+    return 0;
+  }
+  // Only the hottest pages that fit are worth reading; remember how hot each one is.
+  std::vector<std::pair<page_id_t, size_t>> pages;
+  for (size_t rank = 0; rank < std::min<size_t>(num_pages, pool_size_); rank++) {
+    page_id_t page_id;
+    if (!in.read(reinterpret_cast<char *>(&page_id), sizeof(page_id))) {
+      break;
+    }
+    pages.emplace_back(page_id, rank);
+  }
+  std::sort(pages.begin(), pages.end());
+
+  // Split our pages into runs of consecutive ids, and load the coldest run first, so that the replacer, which sees
+  // each run as soon as it is in, ends up ordered by recency about as well as it would have been before the restart.
+  struct Run {
+    size_t begin_;
+    size_t end_;
+    size_t hottest_rank_;
+  };
+  std::vector<Run> runs;
+  for (size_t i = 0; i < pages.size(); i++) {
+    const auto &[page_id, rank] = pages[i];
+    if (page_id % num_instances_ != instance_index_) {
+      continue;
+    }
+    if (runs.empty() || runs.back().end_ != i || pages[i - 1].first != page_id - 1 ||
+        runs.back().end_ - runs.back().begin_ == WARM_UP_MAX_RUN_PAGES) {
+      runs.push_back({i, i, rank});
+    }
+    runs.back().end_ = i + 1;
+    runs.back().hottest_rank_ = std::min(runs.back().hottest_rank_, rank);
+  }
+  std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.hottest_rank_ > b.hottest_rank_; });
+
+  size_t num_loaded = 0;
+  std::vector<std::pair<size_t, frame_id_t>> run;
+  std::vector<char *> run_data;
+  for (const Run &whole_run : runs) {
+    const size_t end = whole_run.end_;
+    size_t next = whole_run.begin_;
+    while (next < end) {
+      std::unique_lock lock(latch_);
+      // Only free frames are used: warm-up must not evict what requests served meanwhile have loaded.
+      if (free_list_.empty()) {
+        return num_loaded;
+      }
+      // A page somebody already loaded ends the part of the run read in one go.
+      while (next < end && page_table_.find(pages[next].first) != page_table_.end()) {
+        next++;
+      }
+      const page_id_t first_page_id = next < end ? pages[next].first : INVALID_PAGE_ID;
+      run.clear();
+      while (next < end && !free_list_.empty() && page_table_.find(pages[next].first) == page_table_.end()) {
+        const frame_id_t frame_id = free_list_.front();
+        free_list_.pop_front();
+        Page *page = &pages_[frame_id];
+        page->page_id_ = pages[next].first;
+        page->pin_count_ = 1;
+        page->is_dirty_ = false;
+        page_table_[page->page_id_] = frame_id;
+        io_in_progress_[frame_id] = true;
+        run.emplace_back(pages[next].second, frame_id);
+        next++;
+      }
+      if (run.empty()) {
+        continue;
+      }
+      lock.unlock();
+
+      run_data.clear();
+      for (const auto &entry : run) {
+        run_data.push_back(pages_[entry.second].GetData());
+      }
+      if (compressed_cache_ != nullptr) {
+        // Read from disk, so any compressed copy is redundant.
+        for (size_t i = 0; i < run.size(); i++) {
+          compressed_cache_->Erase(first_page_id + static_cast<page_id_t>(i));
         }
       }
-      page_table_.erase(page_id);
-      InitPage(idx, INVALID_PAGE_ID);
-      free_list_.push_back(idx);
+      disk_manager_->ReadPages(first_page_id, run_data.data(), run.size());
+
+      // Hand the run to the replacer right away, its coldest page first, so that its frames can be evicted again.
+      std::sort(run.begin(), run.end(), std::greater<>());
+      lock.lock();
+      for (const auto &[rank, frame_id] : run) {
+        FinishFrameIo(frame_id);
+        if (--pages_[frame_id].pin_count_ == 0) {
+          replacer_->Unpin(frame_id);
+        }
+        RecordAccess(frame_id);
+      }
+      num_loaded += run.size();
     }
   }
-  return false;
+  return num_loaded;
+}
+
+void BufferPoolManagerInstance::WarmUpInBackground(const std::string &file_name) {
+  if (warm_up_thread_.joinable()) {
+    warm_up_thread_.join();
+  }
+  warm_up_thread_ = std::thread([this, file_name] { WarmUp(file_name); });
 }
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) { 
-  //TODO  
-  std::lock_guard<std::mutex> lk(latch_);
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id_t idx = page_table_[page_id];
-    pages_[idx].is_dirty_ = is_dirty;
-    pages_[idx].pin_count_--;
-    if (pages_[idx].pin_count_ <= 0) {
-      replacer_->Unpin(idx);
+bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  if (!FindResidentFrame(&lock, page_id, &frame_id)) {
+    // Only a page that is not resident can have a compressed copy.
+    if (compressed_cache_ != nullptr) {
+      compressed_cache_->Erase(page_id);
     }
+    DeallocatePage(page_id);
     return true;
   }
-  return false; 
+  Page *page = &pages_[frame_id];
+  if (page->pin_count_ > 0) {
+    return false;
+  }
+
+  // The page is gone, and so is its history: take the frame out of the replacer without recording an access.
+  replacer_->Evict(frame_id);
+  page_table_.erase(page_id);
+  page->ResetMemory();
+  page->page_id_ = INVALID_PAGE_ID;
+  SetDirty(page, false);
+  if (IsRetiring(frame_id)) {
+    resize_cv_.notify_all();
+  } else {
+    free_list_.push_back(frame_id);
+  }
+  DeallocatePage(page_id);
+  return true;
 }
 
-page_id_t BufferPoolManagerInstance::AllocatePage() {
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
+  auto lock = LockLatch();
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    return false;
+  }
+  Page *page = &pages_[it->second];
+  if (page->pin_count_ <= 0) {
+    return false;
+  }
+  if (is_dirty) {
+    SetDirty(page, true);
+  }
+  if (--page->pin_count_ == 0) {
+    replacer_->Unpin(it->second);
+    if (IsRetiring(it->second)) {
+      resize_cv_.notify_all();
+    }
+  }
+  return true;
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage(data_file_id_t data_file) {
+  size_t slot;
+  if (data_file != ANY_DATA_FILE && disk_manager_->GetNumDataFiles() > 1) {
+    const auto in_data_file = [this, data_file](size_t slot) {
+      return disk_manager_->GetDataFile(static_cast<page_id_t>(slot * num_instances_ + instance_index_)) == data_file;
+    };
+    if (free_page_map_.Take(&slot, in_data_file)) {
+      const auto page_id = static_cast<page_id_t>(slot * num_instances_ + instance_index_);
+      ValidatePageId(page_id);
+      return page_id;
+    }
+    const size_t round = disk_manager_->GetNumDataFiles() * disk_manager_->GetStripePages();
+    const auto first_slot = static_cast<size_t>(next_page_id_.load()) / num_instances_;
+    for (size_t skipped = 0; skipped < round; skipped++) {
+      if (in_data_file(first_slot + skipped)) {
+        for (size_t i = 0; i < skipped; i++) {
+          free_page_map_.Free(first_slot + i, first_slot + skipped);
+        }
+        const auto page_id = static_cast<page_id_t>((first_slot + skipped) * num_instances_ + instance_index_);
+        next_page_id_ = page_id + static_cast<page_id_t>(num_instances_);
+        ValidatePageId(page_id);
+        return page_id;
+      }
+    }
+  }
+  if (free_page_map_.Take(&slot)) {
+    const auto page_id = static_cast<page_id_t>(slot * num_instances_ + instance_index_);
+    ValidatePageId(page_id);
+    return page_id;
+  }
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  if (page_id < 0) {
+    // INVALID_PAGE_ID and the like name no page at all.
+    return;
+  }
+  ValidatePageId(page_id);
+  // A page at or past next_page_id_ was never allocated, so there is nothing to reuse.
+  free_page_map_.Free(static_cast<size_t>(page_id) / num_instances_,
+                      static_cast<size_t>(next_page_id_.load()) / num_instances_);
+}
+
+size_t BufferPoolManagerInstance::GetNumFreePages() {
+  std::scoped_lock lock(latch_);
+  return free_page_map_.NumFree();
+}
+
+void BufferPoolManagerInstance::SaveFreePageMap(HeaderPage *header_page) {
+  std::scoped_lock write_lock(free_page_map_write_latch_);
+  std::vector<uint64_t> words;
+  std::vector<page_id_t> map_pages;
+  page_id_t next_page_id;
+  {
+    std::scoped_lock lock(latch_);
+    words = free_page_map_.GetWords();
+    const size_t num_map_pages =
+        std::max<size_t>(1, (words.size() + FreeSpaceMapPage::MAX_WORDS - 1) / FreeSpaceMapPage::MAX_WORDS);
+    // The map's own pages come from the end of the file rather than from the map, and are kept for good.
+    while (free_page_map_pages_.size() < num_map_pages) {
+      free_page_map_pages_.push_back(next_page_id_);
+      next_page_id_ += num_instances_;
+    }
+    map_pages = free_page_map_pages_;
+    next_page_id = next_page_id_;
+  }
+
+  for (size_t i = 0; i < map_pages.size(); i++) {
+    const size_t first_word = std::min(i * FreeSpaceMapPage::MAX_WORDS, words.size());
+    WriteFreePageMapPage(map_pages[i], i + 1 < map_pages.size() ? map_pages[i + 1] : INVALID_PAGE_ID, next_page_id,
+                         words.data() + first_word, std::min(FreeSpaceMapPage::MAX_WORDS, words.size() - first_word));
+  }
+
+  const std::string record_name = FreePageMapRecordName();
+  if (!header_page->UpdateRecord(record_name, map_pages[0])) {
+    header_page->InsertRecord(record_name, map_pages[0]);
+  }
+}
+
+void BufferPoolManagerInstance::SaveFreePageMapSlot(size_t slot) {
+  std::scoped_lock write_lock(free_page_map_write_latch_);
+  const size_t map_page = slot / 64 / FreeSpaceMapPage::MAX_WORDS;
+  std::vector<uint64_t> words;
+  page_id_t map_page_id;
+  page_id_t next_map_page_id;
+  page_id_t next_page_id;
+  {
+    std::scoped_lock lock(latch_);
+    if (map_page >= free_page_map_pages_.size()) {
+      // The map has not been saved, or not this far: the saved map never offered the slot.
+      return;
+    }
+    // Rewrite the page from the map as it is now; the slots freed since the save are free indeed.
+    const std::vector<uint64_t> &all_words = free_page_map_.GetWords();
+    const size_t first_word = std::min(map_page * FreeSpaceMapPage::MAX_WORDS, all_words.size());
+    words.assign(all_words.begin() + first_word,
+                 all_words.begin() + std::min(first_word + FreeSpaceMapPage::MAX_WORDS, all_words.size()));
+    map_page_id = free_page_map_pages_[map_page];
+    next_map_page_id =
+        map_page + 1 < free_page_map_pages_.size() ? free_page_map_pages_[map_page + 1] : INVALID_PAGE_ID;
+    next_page_id = next_page_id_;
+  }
+  WriteFreePageMapPage(map_page_id, next_map_page_id, next_page_id, words.data(), words.size());
+}
+
+void BufferPoolManagerInstance::WriteFreePageMapPage(page_id_t map_page_id, page_id_t next_map_page_id,
+                                                     page_id_t next_page_id, const uint64_t *words, size_t num_words) {
+  Page buffer;
+  auto *map_page = static_cast<FreeSpaceMapPage *>(&buffer);
+  map_page->Init(map_page_id);
+  map_page->SetNextMapPageId(next_map_page_id);
+  map_page->SetNextPageId(next_page_id);
+  map_page->SetNumWords(static_cast<uint32_t>(num_words));
+  memcpy(map_page->GetWords(), words, num_words * sizeof(uint64_t));
+  disk_manager_->WritePage(map_page_id, map_page->GetData());
+}
+
+bool BufferPoolManagerInstance::LoadFreePageMap(HeaderPage *header_page) {
+  page_id_t map_page_id;
+  if (!header_page->GetRootId(FreePageMapRecordName(), &map_page_id)) {
+    return false;
+  }
+  std::vector<uint64_t> words;
+  std::vector<page_id_t> map_pages;
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  Page buffer;
+  auto *map_page = static_cast<FreeSpaceMapPage *>(&buffer);
+  while (map_page_id != INVALID_PAGE_ID) {
+    ValidatePageId(map_page_id);
+    disk_manager_->ReadPage(map_page_id, map_page->GetData());
+    if (map_pages.empty()) {
+      next_page_id = map_page->GetNextPageId();
+    }
+    map_pages.push_back(map_page_id);
+    words.insert(words.end(), map_page->GetWords(), map_page->GetWords() + map_page->GetNumWords());
+    map_page_id = map_page->GetNextMapPageId();
+  }
+
+  // Pages allocated after the map was saved are in use, although the map does not know it: never go back below a page
+  // this instance has already handed out, or below the last one on disk.
+  const auto num_pages_on_disk = static_cast<size_t>(disk_manager_->GetNumPages());
+  const size_t num_slots_on_disk =
+      num_pages_on_disk > instance_index_ ? (num_pages_on_disk - instance_index_ + num_instances_ - 1) / num_instances_
+                                          : 0;
+  const auto past_disk = static_cast<page_id_t>(num_slots_on_disk * num_instances_ + instance_index_);
+
+  std::scoped_lock lock(latch_);
+  free_page_map_.SetWords(std::move(words));
+  free_page_map_pages_ = std::move(map_pages);
+  next_page_id_ = std::max({next_page_id, next_page_id_.load(), past_disk});
+  return true;
+}
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
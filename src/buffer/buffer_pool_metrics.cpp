@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.cpp
+//
+// Identification: src/buffer/buffer_pool_metrics.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_metrics.h"
+
+namespace bustub {
+
+BufferPoolMetrics &BufferPoolMetrics::operator+=(const BufferPoolMetrics &other) {
+  fetch_hits_ += other.fetch_hits_;
+  fetch_misses_ += other.fetch_misses_;
+  compressed_cache_hits_ += other.compressed_cache_hits_;
+  new_pages_ += other.new_pages_;
+  evictions_ += other.evictions_;
+  dirty_write_backs_ += other.dirty_write_backs_;
+  victim_failures_ += other.victim_failures_;
+  latch_wait_ns_ += other.latch_wait_ns_;
+  pinned_frames_high_water_ += other.pinned_frames_high_water_;
+  return *this;
+}
+
+BufferPoolMetrics BufferPoolCounters::Snapshot() const {
+  BufferPoolMetrics metrics;
+  metrics.fetch_hits_ = counts_[FETCH_HITS].load(std::memory_order_relaxed);
+  metrics.fetch_misses_ = counts_[FETCH_MISSES].load(std::memory_order_relaxed);
+  metrics.compressed_cache_hits_ = counts_[COMPRESSED_CACHE_HITS].load(std::memory_order_relaxed);
+  metrics.new_pages_ = counts_[NEW_PAGES].load(std::memory_order_relaxed);
+  metrics.evictions_ = counts_[EVICTIONS].load(std::memory_order_relaxed);
+  metrics.dirty_write_backs_ = counts_[DIRTY_WRITE_BACKS].load(std::memory_order_relaxed);
+  metrics.victim_failures_ = counts_[VICTIM_FAILURES].load(std::memory_order_relaxed);
+  metrics.latch_wait_ns_ = counts_[LATCH_WAIT_NS].load(std::memory_order_relaxed);
+  return metrics;
+}
+
+}  // namespace bustub
@@ -12,18 +12,94 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : capacity_(num_pages), states_(num_pages) {
+  for (auto &state : states_) {
+    state.store(0, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  // Concurrent victims share the hand, each claiming the next slot, so no two of them ever inspect the same frame in
+  // the same sweep. The loop ends once nothing is evictable; an evictable frame survives at most one full sweep.
+  while (size_.load(std::memory_order_acquire) > 0) {
+    const size_t pos = hand_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+    std::atomic<uint8_t> &state = states_[pos];
+    uint8_t current = state.load(std::memory_order_acquire);
+    if ((current & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      // Second chance. If the CAS fails, the frame was pinned or unpinned meanwhile and is handled next time around.
+      state.compare_exchange_strong(current, current & ~REFERENCED, std::memory_order_acq_rel);
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      *frame_id = static_cast<frame_id_t>(pos);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ClockReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) {
+  // As above, but a frame that is turned down keeps its reference flag. Two sweeps clear every flag there is to clear,
+  // so a third finds nothing new.
+  for (size_t step = 0; step < 2 * capacity_ && size_.load(std::memory_order_acquire) > 0; step++) {
+    const size_t pos = hand_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+    std::atomic<uint8_t> &state = states_[pos];
+    uint8_t current = state.load(std::memory_order_acquire);
+    if ((current & EVICTABLE) == 0 || !accept(static_cast<frame_id_t>(pos))) {
+      continue;
+    }
+    if ((current & REFERENCED) != 0) {
+      state.compare_exchange_strong(current, current & ~REFERENCED, std::memory_order_acq_rel);
+      continue;
+    }
+    if (state.compare_exchange_strong(current, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      *frame_id = static_cast<frame_id_t>(pos);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  const uint8_t previous = states_[frame_id].fetch_and(static_cast<uint8_t>(~EVICTABLE), std::memory_order_acq_rel);
+  if ((previous & EVICTABLE) != 0) {
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  const uint8_t previous = states_[frame_id].fetch_or(EVICTABLE | REFERENCED, std::memory_order_acq_rel);
+  if ((previous & EVICTABLE) == 0) {
+    size_.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+bool ClockReplacer::Evict(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  std::atomic<uint8_t> &state = states_[frame_id];
+  uint8_t current = state.load(std::memory_order_acquire);
+  while ((current & EVICTABLE) != 0) {
+    if (state.compare_exchange_weak(current, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      return true;
+    }
+  }
+  return false;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() { return size_.load(std::memory_order_acquire); }
 
 }  // namespace bustub
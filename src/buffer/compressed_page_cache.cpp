@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstring>
+#include <utility>
+
+#include "common/util/compression_util.h"
+
+namespace bustub {
+
+bool CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  char buffer[MAX_COMPRESSED_SIZE];
+  const size_t size = CompressionUtil::Compress(data, PAGE_SIZE, buffer, sizeof(buffer));
+  if (size == 0 || size + ENTRY_OVERHEAD > capacity_) {
+    Erase(page_id);
+    return false;
+  }
+  auto compressed = std::make_unique<char[]>(size);
+  memcpy(compressed.get(), buffer, size);
+
+  std::scoped_lock lock(latch_);
+  auto it = index_.find(page_id);
+  if (it != index_.end()) {
+    RemoveEntry(it->second);
+  }
+  entries_.push_front(Entry{page_id, std::move(compressed), size});
+  index_[page_id] = entries_.begin();
+  size_ += size + ENTRY_OVERHEAD;
+  while (size_ > capacity_) {
+    RemoveEntry(std::prev(entries_.end()));
+    num_evictions_++;
+  }
+  return true;
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *data) {
+  Entry entry;
+  {
+    std::scoped_lock lock(latch_);
+    auto it = index_.find(page_id);
+    if (it == index_.end()) {
+      return false;
+    }
+    entry = std::move(*it->second);
+    RemoveEntry(it->second);
+  }
+  const bool ok = CompressionUtil::Decompress(entry.data_.get(), entry.size_, data, PAGE_SIZE);
+  BUSTUB_ASSERT(ok, "compressed page is corrupt");
+  return ok;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  auto it = index_.find(page_id);
+  if (it != index_.end()) {
+    RemoveEntry(it->second);
+  }
+}
+
+void CompressedPageCache::RemoveEntry(std::list<Entry>::iterator it) {
+  index_.erase(it->page_id_);
+  size_ -= it->size_ + ENTRY_OVERHEAD;
+  entries_.erase(it);
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::scoped_lock lock(latch_);
+  return size_;
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::scoped_lock lock(latch_);
+  return entries_.size();
+}
+
+size_t CompressedPageCache::GetNumEvictions() {
+  std::scoped_lock lock(latch_);
+  return num_evictions_;
+}
+
+}  // namespace bustub
@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames) {
+  size_ = (num_frames * PAGE_SIZE + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (size_ == 0) {
+    size_ = HUGE_PAGE_SIZE;
+  }
+  void *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  huge_pages_ = base != MAP_FAILED;
+#endif
+  if (base == MAP_FAILED) {
+    // No huge pages reserved (or no permission to use them). Ordinary pages still give a page-aligned arena.
+    base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the buffer pool frame arena");
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(base, size_, MADV_HUGEPAGE);
+#endif
+  }
+  base_ = static_cast<char *>(base);
+}
+
+FrameArena::~FrameArena() { munmap(base_, size_); }
+
+void FrameArena::ReleaseFrom(frame_id_t first_frame_id) {
+  const size_t page_size = huge_pages_ ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const size_t begin = (static_cast<size_t>(first_frame_id) * PAGE_SIZE + page_size - 1) / page_size * page_size;
+  if (begin < size_) {
+    // Best effort: older kernels refuse MADV_DONTNEED on hugetlb mappings, and then the memory simply stays put.
+    madvise(base_ + begin, size_ - begin, MADV_DONTNEED);
+  }
+}
+
+}  // namespace bustub
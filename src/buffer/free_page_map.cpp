@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/buffer/free_page_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_page_map.h"
+
+#include <utility>
+
+namespace bustub {
+
+bool FreePageMap::Free(size_t slot, size_t num_slots) {
+  if (slot >= num_slots) {
+    return false;
+  }
+  const size_t word = slot / 64;
+  const uint64_t bit = uint64_t{1} << (slot % 64);
+  if (word >= words_.size()) {
+    words_.resize(word + 1, 0);
+  }
+  if ((words_[word] & bit) != 0) {
+    return false;
+  }
+  words_[word] |= bit;
+  num_free_++;
+  if (word < first_free_word_) {
+    first_free_word_ = word;
+  }
+  return true;
+}
+
+bool FreePageMap::Take(size_t *slot) {
+  if (num_free_ == 0) {
+    return false;
+  }
+  while (words_[first_free_word_] == 0) {
+    first_free_word_++;
+  }
+  uint64_t &word = words_[first_free_word_];
+  const int bit = __builtin_ctzll(word);
+  word &= word - 1;
+  num_free_--;
+  *slot = first_free_word_ * 64 + bit;
+  return true;
+}
+
+bool FreePageMap::Take(size_t *slot, const std::function<bool(size_t)> &accept) {
+  if (num_free_ == 0) {
+    return false;
+  }
+  for (size_t i = first_free_word_; i < words_.size(); i++) {
+    for (uint64_t bits = words_[i]; bits != 0; bits &= bits - 1) {
+      const size_t candidate = i * 64 + __builtin_ctzll(bits);
+      if (accept(candidate)) {
+        words_[i] &= ~(uint64_t{1} << (candidate % 64));
+        num_free_--;
+        *slot = candidate;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void FreePageMap::SetWords(std::vector<uint64_t> words) {
+  words_ = std::move(words);
+  num_free_ = 0;
+  for (uint64_t word : words_) {
+    num_free_ += __builtin_popcountll(word);
+  }
+  first_free_word_ = 0;
+}
+
+}  // namespace bustub
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : capacity_(num_pages), k_(k), correlated_period_(correlated_period), frames_(num_pages), history_(num_pages * k) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to track at least one access");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+size_t &LRUKReplacer::History(frame_id_t frame_id, size_t i) {
+  const FrameInfo &info = frames_[frame_id];
+  return history_[frame_id * k_ + (info.head_ + k_ - i) % k_];
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  FrameInfo &info = frames_[frame_id];
+  const size_t now = ++current_timestamp_;
+  if (info.count_ > 0 && now - info.last_access_ <= correlated_period_) {
+    // Part of the same burst as the previous access: only the burst grows longer.
+    info.last_access_ = now;
+    return;
+  }
+  if (info.count_ > 0) {
+    // Close the previous burst. Shift the history forward by its length, its start included, so that the burst as a
+    // whole counts as a single reference made at its end, and the gaps between the older references are kept.
+    const size_t correlated_length = info.last_access_ - History(frame_id, 0);
+    for (size_t i = 0; i < info.count_; i++) {
+      History(frame_id, i) += correlated_length;
+    }
+  }
+  info.head_ = (info.head_ + 1) % k_;
+  History(frame_id, 0) = now;
+  info.last_access_ = now;
+  if (info.count_ < k_) {
+    info.count_++;
+  }
+}
+
+void LRUKReplacer::RemoveEvictable(frame_id_t frame_id) {
+  FrameInfo &info = frames_[frame_id];
+  if (info.count_ < k_) {
+    infant_frames_.erase(info.key_);
+  } else {
+    mature_frames_.erase(info.key_);
+  }
+  info.evictable_ = false;
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  return Victim(frame_id, [](frame_id_t) { return true; });
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) {
+  std::scoped_lock guard(latch_);
+  // Infinite backward K-distance first, then the largest finite one. Skip frames still inside their correlated
+  // reference period; they are only taken if nothing else is evictable.
+  const auto find = [&](bool past_period_only) -> const std::pair<size_t, frame_id_t> * {
+    for (const auto *frames : {&infant_frames_, &mature_frames_}) {
+      for (const auto &entry : *frames) {
+        if ((!past_period_only || current_timestamp_ - frames_[entry.second].last_access_ > correlated_period_) &&
+            accept(entry.second)) {
+          return &entry;
+        }
+      }
+    }
+    return nullptr;
+  };
+  const std::pair<size_t, frame_id_t> *victim = find(true);
+  if (victim == nullptr) {
+    victim = find(false);
+  }
+  if (victim == nullptr) {
+    return false;
+  }
+
+  *frame_id = victim->second;
+  RemoveEvictable(*frame_id);
+  // The frame is about to hold a different page, so its history no longer means anything.
+  frames_[*frame_id].count_ = 0;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  if (frames_[frame_id].evictable_) {
+    RemoveEvictable(frame_id);
+  }
+  RecordAccess(frame_id);
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  FrameInfo &info = frames_[frame_id];
+  if (info.evictable_) {
+    return;
+  }
+  if (info.count_ == 0) {
+    // Never pinned through this replacer; the unpin is its first access.
+    RecordAccess(frame_id);
+  }
+  if (info.count_ < k_) {
+    info.key_ = {History(frame_id, info.count_ - 1), frame_id};
+    infant_frames_.insert(info.key_);
+  } else {
+    info.key_ = {History(frame_id, k_ - 1), frame_id};
+    mature_frames_.insert(info.key_);
+  }
+  info.evictable_ = true;
+}
+
+bool LRUKReplacer::Evict(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  if (!frames_[frame_id].evictable_) {
+    return false;
+  }
+  RemoveEvictable(frame_id);
+  frames_[frame_id].count_ = 0;
+  return true;
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock guard(latch_);
+  return infant_frames_.size() + mature_frames_.size();
+}
+
+}  // namespace bustub
@@ -12,51 +12,88 @@
 
 #include "buffer/lru_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {
-    this->max_pages_num = num_pages;
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : capacity_(static_cast<frame_id_t>(num_pages)), nodes_(num_pages + 1, ListNode{0, 0, false}) {
+  // The sentinel starts out pointing at itself, i.e. the list is empty.
+  nodes_[capacity_].prev_ = capacity_;
+  nodes_[capacity_].next_ = capacity_;
 }
 
 LRUReplacer::~LRUReplacer() = default;
 
-bool LRUReplacer::Victim(frame_id_t *frame_id) { 
-    std::lock_guard<std::mutex> lk(mtx);
-    if (!lru_list.size()) {
-        return false;
-    }
-    
-    *frame_id = lru_list.front();
-    lru_list.pop_front();
-    return true;
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  ListNode &node = nodes_[frame_id];
+  nodes_[node.prev_].next_ = node.next_;
+  nodes_[node.next_].prev_ = node.prev_;
+  node.in_list_ = false;
+  size_--;
 }
 
+bool LRUReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock guard(latch_);
+  frame_id_t lru = nodes_[capacity_].next_;
+  if (lru == capacity_) {
+    return false;
+  }
+  Remove(lru);
+  *frame_id = lru;
+  return true;
+}
 
-void LRUReplacer::Pin(frame_id_t frame_id) {
-    std::lock_guard<std::mutex> lk(mtx);
-    std::list<frame_id_t>::iterator it = lru_list.begin();
-    while (it != lru_list.end()) {
-        if (*it == frame_id) {
-            lru_list.erase(it);
-            break;
-        }
-        it++;
+bool LRUReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) {
+  std::scoped_lock guard(latch_);
+  for (frame_id_t frame = nodes_[capacity_].next_; frame != capacity_; frame = nodes_[frame].next_) {
+    if (accept(frame)) {
+      Remove(frame);
+      *frame_id = frame;
+      return true;
     }
+  }
+  return false;
+}
+
+void LRUReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  if (nodes_[frame_id].in_list_) {
+    Remove(frame_id);
+  }
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
-    std::lock_guard<std::mutex> lk(mtx);
-    for(auto it = lru_list.begin(); it != lru_list.end(); it++) {
-        if (*it == frame_id)
-            return;
-    }
-    
-    lru_list.push_back(frame_id);
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  ListNode &node = nodes_[frame_id];
+  if (node.in_list_) {
+    return;
+  }
+  // Append at the MRU end, just before the sentinel.
+  ListNode &head = nodes_[capacity_];
+  node.prev_ = head.prev_;
+  node.next_ = capacity_;
+  nodes_[head.prev_].next_ = frame_id;
+  head.prev_ = frame_id;
+  node.in_list_ = true;
+  size_++;
+}
+
+bool LRUReplacer::Evict(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < capacity_, "frame id out of range");
+  std::scoped_lock guard(latch_);
+  if (!nodes_[frame_id].in_list_) {
+    return false;
+  }
+  Remove(frame_id);
+  return true;
 }
 
 size_t LRUReplacer::Size() {
-    std::lock_guard<std::mutex> lk(mtx);
-    return lru_list.size(); 
+  std::scoped_lock guard(latch_);
+  return size_;
 }
 
 }  // namespace bustub
@@ -12,58 +12,149 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <utility>
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager) {
-  // Allocate and create individual BufferPoolManagerInstances
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel BPM needs at least one instance");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size, static_cast<uint32_t>(num_instances), static_cast<uint32_t>(i), disk_manager, log_manager,
+        replacer_type, max_pool_size));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The worker calls back into the instances, so it has to go first.
+  read_ahead_worker_.reset();
 }
 
-// Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
-ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+void ParallelBufferPoolManager::SaveFreePageMap(HeaderPage *header_page) {
+  for (auto &instance : instances_) {
+    instance->SaveFreePageMap(header_page);
+  }
+}
+
+bool ParallelBufferPoolManager::LoadFreePageMap(HeaderPage *header_page) {
+  bool loaded = true;
+  for (auto &instance : instances_) {
+    loaded = instance->LoadFreePageMap(header_page) && loaded;
+  }
+  return loaded;
+}
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
-  // Get size of all BufferPoolManagerInstances
-  return 0;
+  size_t pool_size = 0;
+  for (auto &instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t pool_size) {
+  const size_t num_instances = instances_.size();
+  for (size_t i = 0; i < num_instances; i++) {
+    const size_t share = pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0);
+    if (share == 0 || share > instances_[i]->GetMaxPoolSize()) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_[i]->Resize(pool_size / num_instances + (i < pool_size % num_instances ? 1 : 0));
+  }
+  return true;
+}
+
+BufferPoolMetrics ParallelBufferPoolManager::GetMetrics() {
+  BufferPoolMetrics metrics;
+  for (auto &instance : instances_) {
+    metrics += instance->GetMetrics();
+  }
+  return metrics;
 }
 
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
-  // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
-  return nullptr;
+  // Instances stripe their page ids (see BufferPoolManagerInstance::AllocatePage), so routing needs no shared state.
+  return instances_[static_cast<size_t>(page_id) % instances_.size()].get();
 }
 
 Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
-  // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return nullptr;
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->FetchPageWithStrategy(page_id, strategy);
 }
 
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
-  // Unpin page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
 }
 
 bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
-  // Flush page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) { return NewPgImp(page_id, nullptr); }
+
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) {
+  return NewPgImp(page_id, strategy, ANY_DATA_FILE);
 }
 
-Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy,
+                                          data_file_id_t data_file) {
+  // Start at a different instance on every call so that new pages spread evenly, then go round once until some
+  // instance has a frame to spare.
+  const size_t num_instances = instances_.size();
+  const size_t start = next_instance_.fetch_add(1, std::memory_order_relaxed) % num_instances;
+  for (size_t i = 0; i < num_instances; i++) {
+    Page *page = instances_[(start + i) % num_instances]->NewPageInDataFile(page_id, data_file, strategy);
+    if (page != nullptr) {
+      return page;
+    }
+  }
   return nullptr;
 }
 
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
-  // Delete page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
+  for (auto &instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+std::shared_ptr<ReadAheadRequest> ParallelBufferPoolManager::ReadAhead(page_id_t first_page_id, size_t num_pages,
+                                                                     next_page_fn next_page,
+                                                                     std::shared_ptr<BufferAccessStrategy> strategy) {
+  std::call_once(read_ahead_worker_created_, [this] {
+    read_ahead_worker_ = std::make_unique<ReadAheadWorker>(this, disk_manager_->CreateAsyncIo(ASYNC_IO_QUEUE_DEPTH));
+  });
+  return read_ahead_worker_->Submit(first_page_id, num_pages, next_page, std::move(strategy));
+}
+
+bool ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                                              BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->PrefetchPage(page_id, next_page, next_page_id, strategy);
+}
+
+BufferPoolManager::PrefetchStatus ParallelBufferPoolManager::StartPrefetchPgImp(page_id_t page_id,
+                                                                                next_page_fn next_page,
+                                                                                page_id_t *next_page_id, AsyncIo *io,
+                                                                                uint64_t tag,
+                                                                                BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->StartPrefetchPage(page_id, next_page, next_page_id, io, tag, strategy);
+}
+
+void ParallelBufferPoolManager::FinishPrefetchPgImp(page_id_t page_id, next_page_fn next_page,
+                                                    page_id_t *next_page_id, bool ok) {
+  GetBufferPoolManager(page_id)->FinishPrefetchPage(page_id, next_page, next_page_id, ok);
 }
 
 }  // namespace bustub
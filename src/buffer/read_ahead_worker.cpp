@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.cpp
+//
+// Identification: src/buffer/read_ahead_worker.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead_worker.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+ReadAheadWorker::ReadAheadWorker(BufferPoolManager *bpm, std::unique_ptr<AsyncIo> io)
+    : bpm_(bpm), io_(std::move(io)) {}
+
+ReadAheadWorker::~ReadAheadWorker() {
+  {
+    std::scoped_lock lock(latch_);
+    for (auto &request : queue_) {
+      request->cancelled_ = true;
+    }
+    running_ = false;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<ReadAheadRequest> ReadAheadWorker::Submit(page_id_t first_page_id, size_t num_pages,
+                                                          next_page_fn next_page,
+                                                          std::shared_ptr<BufferAccessStrategy> strategy) {
+  auto request = std::make_shared<ReadAheadRequest>(first_page_id, num_pages, next_page, std::move(strategy));
+  {
+    std::scoped_lock lock(latch_);
+    queue_.push_back(request);
+    if (!running_) {
+      running_ = true;
+      thread_ = std::thread(&ReadAheadWorker::Run, this);
+    }
+  }
+  cv_.notify_one();
+  return request;
+}
+
+void ReadAheadWorker::Run() {
+  std::vector<std::shared_ptr<ReadAheadRequest>> active;
+  std::vector<IoCompletion> completions;
+  std::unique_lock lock(latch_);
+  while (true) {
+    if (active.empty()) {
+      cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+    }
+    if (!running_) {
+      // Reads in flight still have to be completed, to hand their frames back to the buffer pool.
+      for (auto &request : active) {
+        request->cancelled_ = true;
+      }
+      if (active.empty()) {
+        return;
+      }
+    }
+    while (running_ && !queue_.empty() && active.size() < io_->GetQueueDepth()) {
+      active.push_back(queue_.front());
+      queue_.pop_front();
+    }
+    lock.unlock();
+
+    for (auto &request : active) {
+      if (!request->reading_) {
+        Advance(request.get());
+      }
+    }
+    io_->Submit();
+    if (io_->GetNumPending() > 0) {
+      completions.clear();
+      io_->Reap(&completions, 1);
+      for (const IoCompletion &completion : completions) {
+        auto *request = reinterpret_cast<ReadAheadRequest *>(completion.tag_);
+        page_id_t next_page_id;
+        bpm_->FinishPrefetchPage(request->next_page_id_, request->next_page_, &next_page_id, completion.ok_);
+        request->reading_ = false;
+        request->next_page_id_ = next_page_id;
+        request->remaining_--;
+        Advance(request);
+      }
+    }
+    auto finished = std::partition(active.begin(), active.end(),
+                                   [](const auto &request) { return request->reading_ || !IsDone(*request); });
+    for (auto it = finished; it != active.end(); ++it) {
+      (*it)->finished_ = true;
+    }
+    active.erase(finished, active.end());
+
+    lock.lock();
+  }
+}
+
+void ReadAheadWorker::Advance(ReadAheadRequest *request) {
+  while (!IsDone(*request)) {
+    page_id_t next_page_id;
+    const auto status = bpm_->StartPrefetchPage(request->next_page_id_, request->next_page_, &next_page_id, io_.get(),
+                                                reinterpret_cast<uint64_t>(request), request->strategy_.get());
+    if (status == BufferPoolManager::PrefetchStatus::FAILED) {
+      request->remaining_ = 0;
+    } else if (status == BufferPoolManager::PrefetchStatus::IN_PROGRESS) {
+      // Being read already, typically for an overlapping request of the same scan, which carries on down the chain
+      // from there; its successor is unknown until that read is reaped, and waiting for it here could wait forever.
+      request->remaining_ = 0;
+    } else if (status == BufferPoolManager::PrefetchStatus::QUEUED) {
+      request->reading_ = true;
+      return;
+    } else {
+      request->next_page_id_ = next_page_id;
+      request->remaining_--;
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>  // NOLINT
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bustub {
+
+void ReaderWriterLatch::CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+void ReaderWriterLatch::Wait(std::atomic<uint32_t> *word, uint32_t expected) {
+#ifdef __linux__
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+  if (word->load(std::memory_order_relaxed) == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+void ReaderWriterLatch::WakeAll(std::atomic<uint32_t> *word) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+void ReaderWriterLatch::WLockSlow() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  for (int spins = 0;;) {
+    if ((state & (WRITER | READERS)) == 0) {
+      // Any other waiting writer sets WRITER_WAITING again once this one unlocks and wakes it.
+      if (state_.compare_exchange_weak(state, (state | WRITER) & ~WRITER_WAITING, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    uint32_t wanted = state | WRITER_WAITING | (spins >= SPIN_LIMIT ? PARKED : 0);
+    if (wanted != state) {
+      if (!state_.compare_exchange_weak(state, wanted, std::memory_order_relaxed)) {
+        continue;
+      }
+      state = wanted;
+    }
+    if (spins < SPIN_LIMIT) {
+      spins++;
+      CpuRelax();
+    } else {
+      Wait(&state_, state);
+    }
+    state = state_.load(std::memory_order_relaxed);
+  }
+}
+
+void ReaderWriterLatch::RLockSlow() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  for (int spins = 0;;) {
+    if ((state & (WRITER | WRITER_WAITING)) == 0 && (state & READERS) != READERS) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (spins < SPIN_LIMIT) {
+      spins++;
+      CpuRelax();
+    } else {
+      if ((state & PARKED) == 0) {
+        if (!state_.compare_exchange_weak(state, state | PARKED, std::memory_order_relaxed)) {
+          continue;
+        }
+        state |= PARKED;
+      }
+      Wait(&state_, state);
+    }
+    state = state_.load(std::memory_order_relaxed);
+  }
+}
+
+PerCoreReaderWriterLatch::PerCoreReaderWriterLatch() {
+  size_t num_cpus = std::max(1U, std::thread::hardware_concurrency());
+  num_counters_ = 1;
+  while (num_counters_ < num_cpus && num_counters_ < 64) {
+    num_counters_ *= 2;
+  }
+  counters_ = std::make_unique<Counter[]>(num_counters_);
+}
+
+PerCoreReaderWriterLatch::Counter *PerCoreReaderWriterLatch::CurrentCounter() {
+#ifdef __linux__
+  int cpu = sched_getcpu();
+  if (cpu >= 0) {
+    return &counters_[static_cast<size_t>(cpu) & (num_counters_ - 1)];
+  }
+#endif
+  return &counters_[std::hash<std::thread::id>()(std::this_thread::get_id()) & (num_counters_ - 1)];
+}
+
+void PerCoreReaderWriterLatch::RLock() {
+  while (true) {
+    Counter *counter = CurrentCounter();
+    // Announce the reader before looking for a writer; the writer sets writer_ before adding up the counters, so
+    // one of the two always sees the other.
+    counter->count_.fetch_add(1, std::memory_order_seq_cst);
+    if (writer_.load(std::memory_order_seq_cst) == 0) {
+      return;
+    }
+    // Back out through the same counter: the writer may already have added it up without this reader in it.
+    counter->count_.fetch_sub(1, std::memory_order_seq_cst);
+    drained_.fetch_add(1, std::memory_order_release);
+    ReaderWriterLatch::WakeAll(&drained_);
+    uint32_t writer = writer_.load(std::memory_order_acquire);
+    for (int spins = 0; writer != 0; writer = writer_.load(std::memory_order_acquire)) {
+      if (spins < ReaderWriterLatch::SPIN_LIMIT) {
+        spins++;
+        ReaderWriterLatch::CpuRelax();
+      } else if (writer == WRITER_PARKED || writer_.compare_exchange_weak(writer, WRITER_PARKED)) {
+        ReaderWriterLatch::Wait(&writer_, WRITER_PARKED);
+      }
+    }
+  }
+}
+
+void PerCoreReaderWriterLatch::RUnlock() {
+  CurrentCounter()->count_.fetch_sub(1, std::memory_order_seq_cst);
+  if (writer_.load(std::memory_order_seq_cst) != 0) {
+    drained_.fetch_add(1, std::memory_order_release);
+    ReaderWriterLatch::WakeAll(&drained_);
+  }
+}
+
+void PerCoreReaderWriterLatch::WLock() {
+  writer_latch_.WLock();
+  writer_.store(WRITER_HELD, std::memory_order_seq_cst);
+  for (int spins = 0;;) {
+    uint32_t drained = drained_.load(std::memory_order_acquire);
+    int64_t readers = 0;
+    for (size_t i = 0; i < num_counters_; i++) {
+      readers += counters_[i].count_.load(std::memory_order_seq_cst);
+    }
+    if (readers == 0) {
+      return;
+    }
+    if (spins < ReaderWriterLatch::SPIN_LIMIT) {
+      spins++;
+      ReaderWriterLatch::CpuRelax();
+    } else {
+      ReaderWriterLatch::Wait(&drained_, drained);
+    }
+  }
+}
+
+void PerCoreReaderWriterLatch::WUnlock() {
+  if (writer_.exchange(0, std::memory_order_release) == WRITER_PARKED) {
+    ReaderWriterLatch::WakeAll(&writer_);
+  }
+  writer_latch_.WUnlock();
+}
+
+}  // namespace bustub
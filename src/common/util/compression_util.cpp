@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.cpp
+//
+// Identification: src/common/util/compression_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/compression_util.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+uint32_t Load32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/** Write a length that did not fit in its nibble. */
+bool PutExtraLength(size_t length, uint8_t *out, size_t *op, size_t capacity) {
+  for (; length >= 255; length -= 255) {
+    if (*op >= capacity) {
+      return false;
+    }
+    out[(*op)++] = 255;
+  }
+  if (*op >= capacity) {
+    return false;
+  }
+  out[(*op)++] = static_cast<uint8_t>(length);
+  return true;
+}
+
+/** Read a length that did not fit in its nibble and add it to *length. */
+bool GetExtraLength(const uint8_t *in, size_t *ip, size_t size, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*ip >= size) {
+      return false;
+    }
+    byte = in[(*ip)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Write one sequence; match_length 0 makes it the last one. */
+bool PutSequence(const uint8_t *literals, size_t num_literals, size_t offset, size_t match_length, uint8_t *out,
+                 size_t *op, size_t capacity) {
+  if (*op >= capacity) {
+    return false;
+  }
+  const size_t token_pos = (*op)++;
+  const size_t match_code = match_length == 0 ? 0 : match_length - 4;
+  out[token_pos] = static_cast<uint8_t>(std::min<size_t>(num_literals, 15) << 4 | std::min<size_t>(match_code, 15));
+  if (num_literals >= 15 && !PutExtraLength(num_literals - 15, out, op, capacity)) {
+    return false;
+  }
+  if (*op + num_literals > capacity) {
+    return false;
+  }
+  memcpy(out + *op, literals, num_literals);
+  *op += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (*op + 2 > capacity) {
+    return false;
+  }
+  out[(*op)++] = static_cast<uint8_t>(offset);
+  out[(*op)++] = static_cast<uint8_t>(offset >> 8);
+  return match_code < 15 || PutExtraLength(match_code - 15, out, op, capacity);
+}
+
+}  // namespace
+
+size_t CompressionUtil::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  // Position + 1 of the last occurrence of each hashed 4-byte sequence; 0 for none.
+  uint32_t last_seen[1 << HASH_BITS] = {};
+  size_t op = 0;
+  size_t anchor = 0;
+  size_t ip = 0;
+  while (ip + MIN_MATCH <= src_size) {
+    const uint32_t sequence = Load32(in + ip);
+    const uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    const size_t candidate = last_seen[hash];
+    last_seen[hash] = static_cast<uint32_t>(ip + 1);
+    if (candidate == 0 || ip + 1 - candidate > MAX_OFFSET || Load32(in + candidate - 1) != sequence) {
+      ip++;
+      continue;
+    }
+    const size_t match_start = candidate - 1;
+    size_t match_length = MIN_MATCH;
+    while (ip + match_length < src_size && in[match_start + match_length] == in[ip + match_length]) {
+      match_length++;
+    }
+    if (!PutSequence(in + anchor, ip - anchor, ip - match_start, match_length, out, &op, dst_capacity)) {
+      return 0;
+    }
+    ip += match_length;
+    anchor = ip;
+  }
+  if (!PutSequence(in + anchor, src_size - anchor, 0, 0, out, &op, dst_capacity)) {
+    return 0;
+  }
+  return op;
+}
+
+bool CompressionUtil::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    const uint8_t token = in[ip++];
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !GetExtraLength(in, &ip, src_size, &num_literals)) {
+      return false;
+    }
+    if (num_literals > src_size - ip || num_literals > dst_size - op) {
+      return false;
+    }
+    memcpy(out + op, in + ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == src_size) {
+      break;
+    }
+
+    if (src_size - ip < 2) {
+      return false;
+    }
+    const size_t offset = in[ip] | static_cast<size_t>(in[ip + 1]) << 8;
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !GetExtraLength(in, &ip, src_size, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > dst_size - op) {
+      return false;
+    }
+    if (offset >= match_length) {
+      memcpy(out + op, out + op - offset, match_length);
+      op += match_length;
+    } else {
+      // The match overlaps the bytes it produces, e.g. a run of one repeated byte.
+      for (size_t i = 0; i < match_length; i++, op++) {
+        out[op] = out[op - offset];
+      }
+    }
+  }
+  return op == dst_size;
+}
+
+}  // namespace bustub
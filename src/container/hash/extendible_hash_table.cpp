@@ -24,15 +24,19 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                     data_file_id_t data_file)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)),
+      data_file_(data_file) {
   //  implement me!
-  Page* pg = buffer_pool_manager_->NewPage(&directory_page_id_);
+  Page* pg = buffer_pool_manager_->NewPageInDataFile(&directory_page_id_, data_file_);
   HashTableDirectoryPage* hashTableDirectoryPage = reinterpret_cast<HashTableDirectoryPage*>(pg->GetData());
   hashTableDirectoryPage->SetPageId(directory_page_id_);
 
   page_id_t bktPgId = INVALID_PAGE_ID;
-  buffer_pool_manager_->NewPage(&bktPgId);
+  buffer_pool_manager_->NewPageInDataFile(&bktPgId, data_file_);
   // HASH_TABLE_BUCKET_TYPE* hashTableBucketPage = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*> (bktPg->GetData());
   hashTableDirectoryPage->SetBucketPageId(0, bktPgId);
   buffer_pool_manager_->UnpinPage(bktPgId, true);
@@ -86,8 +90,8 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
   uint32_t bktPgId = KeyToPageId(key, dirPg);
   table_latch_.RUnlock();
   buffer_pool_manager_->UnpinPage(directory_page_id_, true);
-  HASH_TABLE_BUCKET_TYPE * bktPg = FetchBucketPage(bktPgId);
-  auto pg = reinterpret_cast<Page *> (bktPg);
+  Page *pg = buffer_pool_manager_->FetchPage(bktPgId);
+  HASH_TABLE_BUCKET_TYPE * bktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(pg->GetData());
   pg->RLatch();
   bool res = bktPg->GetValue(key, comparator_, result);
   pg->RUnlatch();
@@ -107,8 +111,8 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
   table_latch_.RUnlock();
   buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 
-  HASH_TABLE_BUCKET_TYPE * bktPg = FetchBucketPage(bktPgId);
-  auto pg = reinterpret_cast<Page *> (bktPg);
+  Page *pg = buffer_pool_manager_->FetchPage(bktPgId);
+  HASH_TABLE_BUCKET_TYPE * bktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(pg->GetData());
   pg->WLatch();
   if (bktPg->IsFull()) {
     pg->WUnlatch();
@@ -134,9 +138,9 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 
   uint32_t bktPgId = KeyToPageId(key, dirPg);
 
-  HASH_TABLE_BUCKET_TYPE * bktPg = FetchBucketPage(bktPgId);
+  Page *pg = buffer_pool_manager_->FetchPage(bktPgId);
+  HASH_TABLE_BUCKET_TYPE * bktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(pg->GetData());
 
-  auto pg = reinterpret_cast<Page *> (bktPg);
   pg->WLatch();
 
   if (bktPg->IsFull()) {
@@ -149,8 +153,8 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
     if (local_depth <= dirPg->GetGlobalDepth()) {
       //不需要增加global depth
       page_id_t newPid;
-      auto newPg = buffer_pool_manager_->NewPage(&newPid);
-      HASH_TABLE_BUCKET_TYPE* newBktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*>(newPg);
+      auto newPg = buffer_pool_manager_->NewPageInDataFile(&newPid, data_file_);
+      HASH_TABLE_BUCKET_TYPE* newBktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*>(newPg->GetData());
       newPg->WLatch();
       //写入数据
       //new page中插入和插入值一样的hash数值，原始页负责其他部分
@@ -211,8 +215,8 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 
       //新建一个page
       page_id_t newPid;
-      auto newPg = buffer_pool_manager_->NewPage(&newPid);
-      HASH_TABLE_BUCKET_TYPE* newBktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*>(newPg);
+      auto newPg = buffer_pool_manager_->NewPageInDataFile(&newPid, data_file_);
+      HASH_TABLE_BUCKET_TYPE* newBktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*>(newPg->GetData());
       newPg->WLatch();
       //写入数据
       //new page中插入和插入值一样的hash数值，原始页负责其他部分
@@ -277,9 +281,9 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
   HashTableDirectoryPage * dirPg= FetchDirectoryPage();
   uint32_t bktPgId = KeyToPageId(key, dirPg);
 
-  HASH_TABLE_BUCKET_TYPE * bktPg = FetchBucketPage(bktPgId);
+  Page *pg = buffer_pool_manager_->FetchPage(bktPgId);
+  HASH_TABLE_BUCKET_TYPE * bktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(pg->GetData());
 
-  auto pg = reinterpret_cast<Page *> (bktPg);
   pg->WLatch();
   bool res = bktPg->Remove(key, value, comparator_);
   bool isEmpty = bktPg->IsEmpty();
@@ -306,9 +310,9 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   HashTableDirectoryPage * dirPg= FetchDirectoryPage();
   uint32_t bktPgId = KeyToPageId(key, dirPg);
   auto idx = KeyToDirectoryIndex(key, dirPg);
-  HASH_TABLE_BUCKET_TYPE * bktPg = FetchBucketPage(bktPgId);
+  Page *pg = buffer_pool_manager_->FetchPage(bktPgId);
+  HASH_TABLE_BUCKET_TYPE * bktPg = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(pg->GetData());
 
-  auto pg = reinterpret_cast<Page *> (bktPg);
   pg->WLatch();
   if (bktPg->IsEmpty() && dirPg->GetLocalDepth(idx) > 0) {
     //
@@ -48,6 +48,11 @@ void InsertExecutor::Init() {
     childExecutor_.get()->Init();
   }
 
+  // Inserting the output of a query, or more raw values than the ring holds, is a bulk load.
+  if (!isRawInsert_ || plan_->RawValues().size() > BUFFER_ACCESS_STRATEGY_RING_SIZE) {
+    bulkStrategy_ = std::make_unique<BufferAccessStrategy>();
+  }
+
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
@@ -62,7 +67,7 @@ bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
     }
     *tuple = Tuple(plan_->RawValuesAt(rawIdx_++), &tableInfo_->schema_);
 
-    tableHeap_->InsertTuple(*tuple, rid, exec_ctx_->GetTransaction());
+    tableHeap_->InsertTuple(*tuple, rid, exec_ctx_->GetTransaction(), bulkStrategy_.get());
 
     if (txn->IsSharedLocked(*rid)) {
       if (!lock_mgr->LockUpgrade(txn, *rid)) {
@@ -93,7 +98,7 @@ bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
       return false;
     }
 
-    tableHeap_->InsertTuple(*tuple, rid, exec_ctx_->GetTransaction());
+    tableHeap_->InsertTuple(*tuple, rid, exec_ctx_->GetTransaction(), bulkStrategy_.get());
 
     if (txn->IsSharedLocked(*rid)) {
       if (!lock_mgr->LockUpgrade(txn, *rid)) {
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy confines the pages that a bulk operation brings into the buffer pool, such as a scan of a table
+ * much larger than the pool or a bulk insert, to a small ring of frames. On a miss, instead of asking the replacer for
+ * a victim, the buffer pool recycles the frame that the ring used ring_size misses ago, as long as that frame still
+ * holds the page the ring put there and nobody has it pinned. Hot pages elsewhere in the pool are left alone.
+ *
+ * Every buffer pool instance gets a ring of its own. A strategy may be shared, e.g. by a scan and its read-ahead.
+ */
+class BufferAccessStrategy {
+ public:
+  /** What a ring slot remembers: the page it last brought in, and the frame that page went into. */
+  struct Slot {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    frame_id_t frame_id_{-1};
+  };
+
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size the number of frames per buffer pool instance that the operation may recycle
+   */
+  explicit BufferAccessStrategy(size_t ring_size = BUFFER_ACCESS_STRATEGY_RING_SIZE) : ring_size_(ring_size) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /**
+   * Move on to the next slot of an instance's ring.
+   * @param instance_index the buffer pool instance
+   * @param[out] slot_index the slot, to be passed to Remember
+   * @return what the slot held; a page id of INVALID_PAGE_ID if it was never used
+   */
+  Slot Advance(uint32_t instance_index, size_t *slot_index);
+
+  /**
+   * Record the page that a slot brought in.
+   * @param instance_index the buffer pool instance
+   * @param slot_index the slot returned by Advance
+   * @param page_id the page
+   * @param frame_id the frame now holding the page
+   */
+  void Remember(uint32_t instance_index, size_t slot_index, page_id_t page_id, frame_id_t frame_id);
+
+  /** @return the number of frames per buffer pool instance in the ring */
+  size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  const size_t ring_size_;
+  /** One ring per buffer pool instance, created on first use. */
+  std::vector<std::vector<Slot>> rings_;
+  /** The slot each ring advances to next. */
+  std::vector<size_t> next_slot_;
+  /** Protects rings_ and next_slot_. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -13,12 +13,17 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/read_ahead_worker.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
 #include "storage/page/page.h"
 
 namespace bustub {
@@ -29,6 +34,11 @@ namespace bustub {
 class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
+  /**
+   * How far StartPrefetchPage got: the page could not be loaded, is loaded, is being read on the caller's AsyncIo, or
+   * is already being read by someone else.
+   */
+  enum class PrefetchStatus { FAILED, DONE, QUEUED, IN_PROGRESS };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
 
   BufferPoolManager() = default;
@@ -84,9 +94,128 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page on behalf of a bulk operation. On a miss, the page is read into a frame of the strategy's ring.
+   * @param page_id id of page to be fetched
+   * @param strategy the bulk operation's ring, or nullptr to behave like FetchPage
+   * @return the requested page
+   */
+  Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPgImp(page_id, strategy);
+  }
+
+  /**
+   * Create a page on behalf of a bulk operation, in a frame of the strategy's ring.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring, or nullptr to behave like NewPage
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageWithStrategy(page_id_t *page_id, BufferAccessStrategy *strategy) { return NewPgImp(page_id, strategy); }
+
+  /**
+   * Create a page that lives in the given data file of a multi-file database, so that an object can be kept on one
+   * device. The data file is a preference: when no page in it can be had, the page goes elsewhere.
+   * @param[out] page_id id of created page
+   * @param data_file the data file the page should live in; ANY_DATA_FILE to behave like NewPageWithStrategy
+   * @param strategy the bulk operation's ring, if any
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInDataFile(page_id_t *page_id, data_file_id_t data_file, BufferAccessStrategy *strategy = nullptr) {
+    return NewPgImp(page_id, strategy, data_file);
+  }
+
+  /**
+   * Bring a page into the buffer pool without pinning it, e.g. ahead of a scan. A page that is not yet resident is
+   * only loaded if a free or clean frame is available; no dirty page is written back to make room.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows, as reported by next_page
+   * @param strategy the ring of the scan the page is loaded for, if any
+   * @return false if the page could not be loaded
+   */
+  bool PrefetchPage(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                    BufferAccessStrategy *strategy = nullptr) {
+    return PrefetchPgImp(page_id, next_page, next_page_id, strategy);
+  }
+
+  /**
+   * Like PrefetchPage, but instead of waiting for a read, queue it on the caller's AsyncIo and return.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows, if the status is DONE
+   * @param io the AsyncIo to queue the read on; the caller submits it
+   * @param tag the tag of the read
+   * @param strategy the ring of the scan the page is loaded for, if any
+   * @return QUEUED if the read was queued; call FinishPrefetchPage once io has completed it. IN_PROGRESS if the page
+   * is in the middle of I/O already, which StartPrefetchPage never waits for: the I/O may be one the caller queued
+   * itself and has yet to submit.
+   */
+  PrefetchStatus StartPrefetchPage(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, AsyncIo *io,
+                                   uint64_t tag, BufferAccessStrategy *strategy = nullptr) {
+    return StartPrefetchPgImp(page_id, next_page, next_page_id, io, tag, strategy);
+  }
+
+  /**
+   * Make a page whose read StartPrefetchPage queued available, once the read has completed.
+   * @param page_id id of the page
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows; INVALID_PAGE_ID if the read failed
+   * @param ok false if the read failed, in which case the page is dropped again
+   */
+  void FinishPrefetchPage(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, bool ok) {
+    FinishPrefetchPgImp(page_id, next_page, next_page_id, ok);
+  }
+
+  /**
+   * Start loading a chain of pages in the background, ahead of a sequential scan along it.
+   * @param first_page_id the first page to load
+   * @param num_pages how many pages of the chain to load
+   * @param next_page how to find the page after a given one
+   * @param strategy the ring of the scan, if it has one; pages are loaded into it
+   * @return the request, which the caller cancels once it stops scanning; nullptr if read-ahead is not supported
+   */
+  virtual std::shared_ptr<ReadAheadRequest> ReadAhead(page_id_t first_page_id, size_t num_pages,
+                                                      next_page_fn next_page,
+                                                      std::shared_ptr<BufferAccessStrategy> strategy) {
+    return nullptr;
+  }
+
+  /**
+   * Write the map of deallocated pages to disk, and record where it is in the header page. Pages deallocated after
+   * this are only remembered until the next save, so call it at checkpoints and at shutdown.
+   * @param header_page the header page, pinned and write latched by the caller
+   */
+  virtual void SaveFreePageMap(HeaderPage *header_page) {}
+
+  /**
+   * Read back the map of deallocated pages saved by SaveFreePageMap, together with the next page id to allocate. That
+   * id is moved past any page allocated since, as far as this buffer pool or the data files know of it. Call it before
+   * the first page is allocated.
+   * @param header_page the header page, pinned and latched by the caller
+   * @return false if the header page has no record of a saved map
+   */
+  virtual bool LoadFreePageMap(HeaderPage *header_page) { return false; }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
+  /**
+   * Grow or shrink the buffer pool while it is in use. Shrinking writes back and evicts the pages held by the frames
+   * that go away, and waits for those that are pinned to be unpinned.
+   * @param pool_size the new size of the buffer pool
+   * @return false if the buffer pool cannot take that size
+   */
+  virtual bool Resize(size_t pool_size) { return false; }
+
+  /** @return a snapshot of the counters of the buffer pool; all zero if it keeps none */
+  virtual BufferPoolMetrics GetMetrics() { return {}; }
+
+  /**
+   * @param page_id id of a page
+   * @return true if the buffer pool holds changes to the page that are not on disk yet; true if it cannot tell
+   */
+  virtual bool IsPageDirty(page_id_t page_id) { return true; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +237,14 @@ class BufferPoolManager {
    */
   virtual Page *FetchPgImp(page_id_t page_id) = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool on behalf of a bulk operation.
+   * @param page_id id of page to be fetched
+   * @param strategy the bulk operation's ring; nullptr for an ordinary fetch
+   * @return the requested page
+   */
+  virtual Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) { return FetchPgImp(page_id); }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +267,25 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page in the buffer pool on behalf of a bulk operation.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) { return NewPgImp(page_id); }
+
+  /**
+   * Creates a new page in the buffer pool, preferably in the given data file.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @param data_file the data file the page should live in; ANY_DATA_FILE for no preference
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy, data_file_id_t data_file) {
+    return NewPgImp(page_id, strategy);
+  }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +297,44 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Load a page into the buffer pool without pinning it.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param strategy the ring to load the page into, if any
+   * @return false if the page could not be loaded
+   */
+  virtual bool PrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                             BufferAccessStrategy *strategy) {
+    return false;
+  }
+
+  /**
+   * Start loading a page into the buffer pool without pinning it. By default the page is loaded synchronously.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows, if the status is DONE
+   * @param io the AsyncIo to queue a read on
+   * @param tag the tag of the read
+   * @param strategy the ring to load the page into, if any
+   * @return whether the page is loaded, being read or could not be loaded
+   */
+  virtual PrefetchStatus StartPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                                            AsyncIo *io, uint64_t tag, BufferAccessStrategy *strategy) {
+    return PrefetchPgImp(page_id, next_page, next_page_id, strategy) ? PrefetchStatus::DONE : PrefetchStatus::FAILED;
+  }
+
+  /**
+   * Finish loading a page whose read StartPrefetchPgImp queued.
+   * @param page_id id of the page
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param ok false if the read failed
+   */
+  virtual void FinishPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, bool ok) {
+    *next_page_id = INVALID_PAGE_ID;
+  }
 };
 }  // namespace bustub
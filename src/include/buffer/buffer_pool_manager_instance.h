@@ -12,11 +12,22 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/free_page_map.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -34,8 +45,11 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the largest size Resize may grow the pool to; 0 for pool_size
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +57,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the largest size Resize may grow the pool to; 0 for pool_size
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,9 +72,101 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
+  /** @return the largest size the buffer pool can be resized to */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  /**
+   * Change the number of frames in use, between 1 and GetMaxPoolSize(). The frames of every possible size are
+   * allocated up front, so Page pointers stay valid; the memory of the frames a shrink takes out of use is given back
+   * to the operating system, as far as the page size of the frame arena allows.
+   */
+  bool Resize(size_t pool_size) override;
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
+  BufferPoolMetrics GetMetrics() override;
+
+  /** A page whose write-back is under way counts as dirty until the write is done; one being evicted is waited for. */
+  bool IsPageDirty(page_id_t page_id) override;
+
+  /**
+   * Keep clean pages evicted from this instance in a CompressedPageCache, and look there before reading a page from
+   * disk. Must be called before the buffer pool is used.
+   * @param capacity the most bytes the compressed cache may take; 0 to do without one
+   */
+  void EnableCompressedCache(size_t capacity);
+
+  /** @return the compressed page cache, nullptr if not enabled */
+  CompressedPageCache *GetCompressedCache() { return compressed_cache_.get(); }
+
+  /**
+   * Start a background thread that writes dirty, unpinned pages back to disk in page id order, ASYNC_IO_QUEUE_DEPTH
+   * at a time, so that eviction nearly always finds a clean victim instead of writing on behalf of the query that
+   * missed. The flusher wakes up
+   * every background_flush_interval, or as soon as more than dirty_high_water frames are dirty, and writes until no
+   * more than half of dirty_high_water frames remain dirty.
+   * @param dirty_high_water number of dirty frames above which the flusher writes immediately
+   * @param max_writes_per_second upper bound on the pages written per second by the flusher, 0 for no limit
+   */
+  void RunBackgroundFlusher(size_t dirty_high_water, size_t max_writes_per_second = 0);
+
+  /** Stop and join the background flusher, if it is running. */
+  void StopBackgroundFlusher();
+
+  std::shared_ptr<ReadAheadRequest> ReadAhead(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                                              std::shared_ptr<BufferAccessStrategy> strategy) override;
+
+  /**
+   * Have the read-ahead worker read straight into frames registered with the kernel as fixed buffers, which saves
+   * mapping the frame for every read. This pins the whole frame arena in memory, and a shrinking Resize no longer
+   * gives memory back. Must be called before the first ReadAhead; has no effect without io_uring.
+   */
+  void RegisterFramesForReadAhead() { register_frames_for_read_ahead_ = true; }
+
+  /**
+   * Write the free page map of this instance to its chain of FreeSpaceMapPages, bypassing the buffer pool, and record
+   * the first page of the chain in the header page. From then on, NewPage rewrites the map page of every page it takes
+   * out of the map, so that a map read back after a crash never offers a page that is in use.
+   * @param header_page the header page, pinned and write latched by the caller
+   */
+  void SaveFreePageMap(HeaderPage *header_page) override;
+
+  bool LoadFreePageMap(HeaderPage *header_page) override;
+
+  /** @return the number of deallocated pages waiting to be reused */
+  size_t GetNumFreePages();
+
+  /**
+   * Write the ids of the resident pages to a file, most recently used first, for WarmUp to read after a restart. The
+   * file is replaced atomically, so a crash during the dump leaves the previous one intact.
+   * @param file_name the file to write
+   * @return false if the file could not be written
+   */
+  bool DumpResidentPages(const std::string &file_name);
+
+  /**
+   * Dump the resident pages every interval from a background thread, and once more when stopped.
+   * @param file_name the file to write
+   * @param interval time between dumps
+   */
+  void RunResidentPageDumps(const std::string &file_name, std::chrono::milliseconds interval);
+
+  /** Stop the periodic dumps, if they are running, after a final dump. Called by the destructor. */
+  void StopResidentPageDumps();
+
+  /**
+   * Load the pages listed by an earlier DumpResidentPages, as many of the most recently used ones as fit. Runs of
+   * consecutive pages are read with one DiskManager::ReadPages call each, the coldest run first, and each run is
+   * handed to the replacer as soon as it is in. Only free frames are used, so nothing resident is evicted.
+   * @param file_name the file written by DumpResidentPages
+   * @return the number of pages loaded
+   */
+  size_t WarmUp(const std::string &file_name);
+
+  /** Run WarmUp on a background thread, so that requests can be served meanwhile. */
+  void WarmUpInBackground(const std::string &file_name);
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +175,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool on behalf of a bulk operation.
+   * @param page_id id of page to be fetched
+   * @param strategy the bulk operation's ring; nullptr for an ordinary fetch
+   * @return the requested page
+   */
+  Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -88,6 +205,23 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool on behalf of a bulk operation.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Creates a new page in the buffer pool, in the given data file if this instance can find it a page there.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @param data_file the data file the page should live in; ANY_DATA_FILE for no preference
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy, data_file_id_t data_file) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,23 +230,92 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   bool DeletePgImp(page_id_t page_id) override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the dirty pages in the buffer pool to disk, in page id order and in batches of FLUSH_MAX_BATCH_PAGES,
+   * writing runs of consecutive pages with one vectored write each and syncing once at the end. Writes already under
+   * way are waited for first, so the sync covers them too.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Load a page into the buffer pool without pinning it.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param strategy the ring to load the page into, if any
+   * @return false if the page could not be loaded
+   */
+  bool PrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                     BufferAccessStrategy *strategy) override;
+
+  /**
+   * Start loading a page into the buffer pool without pinning it. A page that is not resident gets a frame marked as
+   * in I/O, and its read is queued on io.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows, if the status is DONE
+   * @param io the AsyncIo to queue the read on; nullptr to read synchronously
+   * @param tag the tag of the read
+   * @param strategy the ring to load the page into, if any
+   * @return whether the page is loaded, being read or could not be loaded
+   */
+  PrefetchStatus StartPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, AsyncIo *io,
+                                    uint64_t tag, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Finish loading a page whose read StartPrefetchPgImp queued.
+   * @param page_id id of the page
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param ok false if the read failed
+   */
+  void FinishPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, bool ok) override;
+
+  /**
+   * Hand a prefetched frame to the replacer, or back to the free list if its read failed.
+   * @param frame_id the frame, pinned once and in I/O
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param ok false if the read failed
+   */
+  void FinishPrefetch(frame_id_t frame_id, next_page_fn next_page, page_id_t *next_page_id, bool ok);
+
+  /**
+   * Allocate a page on disk: the lowest deallocated page of this instance if there is one, a new one otherwise.
+   * Given a data file, prefer the lowest deallocated page in it, then the first new page in it within one round of
+   * stripes; the new pages skipped on the way are deallocated, for whoever wants a page in their data file. If neither
+   * exists, e.g. because this instance's page ids never fall in that file, allocate as if there were no preference.
+   * Caller must hold latch_.
+   * @param data_file the data file the page should live in; ANY_DATA_FILE for no preference
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(data_file_id_t data_file = ANY_DATA_FILE);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage can hand it out again. Caller must hold latch_.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Write the map page holding a slot taken out of the free page map since it was saved, so that the saved map no
+   * longer offers it. Caller must not hold latch_.
+   * @param slot the slot taken
+   */
+  void SaveFreePageMapSlot(size_t slot);
+
+  /**
+   * Write one page of the saved free page map.
+   * @param map_page_id id of the map page
+   * @param next_map_page_id id of the map page after it, or INVALID_PAGE_ID
+   * @param next_page_id the next page id to allocate
+   * @param words the part of the map the page holds
+   * @param num_words how many words that is
+   */
+  void WriteFreePageMapPage(page_id_t map_page_id, page_id_t next_map_page_id, page_id_t next_page_id,
+                            const uint64_t *words, size_t num_words);
+
+  /** @return the name of this instance's free page map record in the header page */
+  std::string FreePageMapRecordName() const { return "free_page_map_" + std::to_string(instance_index_); }
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,12 +324,113 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  // size_t findPage(page_id_t page_id);
+  /**
+   * Find a frame that can hold a new page: the next frame of the strategy's ring if it can be recycled, otherwise a
+   * free frame if there is one, otherwise a victim from the replacer. A dirty victim is written back first, and a
+   * victim from the replacer goes to the compressed page cache, if there is one, unless write_back_dirty is false.
+   * The latch is released for the duration of that work; meanwhile the frame is marked as in I/O, so anyone asking for
+   * the old page waits on the frame instead of reading a stale copy from disk.
+   * @param lock the held lock on latch_; it may be released and reacquired
+   * @param[out] frame_id the frame, which is unpinned, clean and no longer in the page table
+   * @param write_back_dirty if false, take only a clean victim and leave the dirty frames untouched in the replacer;
+   * latch_ then stays held
+   * @param strategy the ring of the bulk operation the frame is for, or nullptr
+   * @param[out] ring_slot the ring slot to Remember the new page in, if strategy is not nullptr
+   * @return false if every frame is pinned, or, without write_back_dirty, pinned or dirty
+   */
+  bool AcquireFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id, bool write_back_dirty = true,
+                    BufferAccessStrategy *strategy = nullptr, size_t *ring_slot = nullptr);
+
+  /**
+   * Take the frame that the next slot of a ring used last time around, out of the replacer. Caller must hold latch_.
+   * @param strategy the ring
+   * @param[out] ring_slot the slot
+   * @param write_back_dirty if false, a dirty frame is not taken
+   * @param[out] frame_id the frame, which is unpinned but may still be dirty and in the page table
+   * @return false if the slot is empty or its frame has been reused or pinned since
+   */
+  bool TakeRingFrame(BufferAccessStrategy *strategy, size_t *ring_slot, bool write_back_dirty, frame_id_t *frame_id);
 
-  void InitPage(frame_id_t frame_id, page_id_t page_id);
+  /**
+   * Wait until the page is resident and not in I/O.
+   * @param lock the held lock on latch_; it is released while waiting
+   * @param page_id the page to look for
+   * @param[out] frame_id the frame holding the page
+   * @return false if the page is not in the buffer pool
+   */
+  bool FindResidentFrame(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t *frame_id);
+
+  /**
+   * Lock latch_, adding the time spent waiting for it, if any, to the latch wait counter. Only a latch that is held
+   * when we get to it pays for reading the clock.
+   */
+  std::unique_lock<std::mutex> LockLatch() {
+    std::unique_lock lock(latch_, std::try_to_lock);
+    if (lock.owns_lock()) {
+      return lock;
+    }
+    WaitForLatch(&lock);
+    return lock;
+  }
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** The slow path of LockLatch: lock a latch_ that somebody else holds, and time the wait. */
+  void WaitForLatch(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * Count the frames in use that the replacer cannot evict, and raise pinned_frames_high_water_ to it. This is done
+   * whenever a frame is needed, not on every pin, to keep the hit path free of it. Caller must hold latch_.
+   */
+  void SamplePinnedFrames();
+
+  /** Mark the end of I/O on a frame and wake everyone waiting for it. Caller must hold latch_. */
+  void FinishFrameIo(frame_id_t frame_id);
+
+  /**
+   * Pin a frame and mark its page clean for a write-back, counting it in write_backs_in_flight_ until
+   * FinishWriteBack. The frame stays out of the replacer, so it cannot be evicted while it is being written. Caller
+   * must hold latch_.
+   */
+  void StartWriteBack(frame_id_t frame_id);
+
+  /** Unpin a frame after its write-back, and wake the flushes waiting for it. Caller must hold latch_. */
+  void FinishWriteBack(frame_id_t frame_id);
+
+  /**
+   * Take a frame above pool_size_ out of use, writing back and evicting its page first.
+   * @param lock the held lock on latch_; it is released during a write-back
+   * @param frame_id the frame
+   * @return false if the frame is pinned or in I/O, so it has to be tried again later
+   */
+  bool RetireFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id);
+
+  /** @return true if the frame is above pool_size_, i.e. a shrinking Resize is waiting for it */
+  bool IsRetiring(frame_id_t frame_id) const { return static_cast<size_t>(frame_id) >= pool_size_; }
+
+  /**
+   * Write a resident page back to disk. The frame is pinned and latch_ is released during the write.
+   * @param lock the held lock on latch_; it is released and reacquired
+   * @param page_id the page to write
+   * @param only_dirty_unpinned if true, skip the page unless it is dirty and unpinned
+   * @return true if the page was written
+   */
+  bool WritePageBack(std::unique_lock<std::mutex> *lock, page_id_t page_id, bool only_dirty_unpinned);
+
+  /** Set or clear a frame's dirty flag and keep num_dirty_ up to date. Caller must hold latch_. */
+  void SetDirty(Page *page, bool is_dirty);
+
+  /** Body of the background flusher thread. */
+  void BackgroundFlush();
+
+  /** Mark a frame as just accessed, for DumpResidentPages. Caller must hold latch_. */
+  void RecordAccess(frame_id_t frame_id) { last_access_[frame_id] = ++access_clock_; }
+
+  /** First word of a DumpResidentPages file. */
+  static constexpr uint32_t RESIDENT_PAGES_MAGIC = 0x42555048;
+
+  /** Number of frames in use: frames 0 to pool_size_ - 1. Only changed by Resize, under latch_. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames allocated. */
+  const size_t max_pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
@@ -140,13 +444,78 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
+  /** The data of every frame; pages_[i] points at frame i of it. */
+  FrameArena arena_;
   /** Page table for keeping track of buffer pool pages. */
   std::unordered_map<page_id_t, frame_id_t> page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Deallocated pages of this instance, by page_id_ / num_instances_. */
+  FreePageMap free_page_map_;
+  /** The pages the free page map is saved in, allocated on the first save and never freed. */
+  std::vector<page_id_t> free_page_map_pages_;
+  /**
+   * Orders the writes of the saved free page map, so that a write of a later state of the map is never overtaken by
+   * one of an earlier state. Taken before latch_.
+   */
+  std::mutex free_page_map_write_latch_;
+  /** True for frames whose contents are being read from or written back to disk without latch_ held. */
+  std::vector<bool> io_in_progress_;
+  /**
+   * Per frame, the write-backs under way whose page is pinned and already marked clean, but not on disk yet. Frames
+   * written back on eviction are in io_in_progress_ instead.
+   */
+  std::vector<uint32_t> write_backs_in_flight_;
+  /** Per-frame condition on which requesters of an in-I/O frame, and flushes waiting for a write-back, wait. */
+  std::unique_ptr<std::condition_variable[]> io_done_;
+  /** Number of frames with the dirty flag set. */
+  size_t num_dirty_{0};
+  /** The background flusher, if started. */
+  std::thread flusher_thread_;
+  /** True while the background flusher should keep running. */
+  bool flusher_running_{false};
+  /** Dirty frame count that wakes the background flusher. */
+  size_t dirty_high_water_{0};
+  /** Write rate cap of the background flusher, 0 for no limit. */
+  size_t max_writes_per_second_{0};
+  /** Wakes the background flusher early. */
+  std::condition_variable flusher_cv_;
+  /** Value of access_clock_ at the last access to each frame. */
+  std::vector<uint64_t> last_access_;
+  /** Counts accesses to pages of this instance. */
+  uint64_t access_clock_{0};
+  /** The thread dumping the resident pages periodically, if started. */
+  std::thread dump_thread_;
+  /** True while the dump thread should keep running. */
+  bool dump_running_{false};
+  /** Wakes the dump thread early. */
+  std::condition_variable dump_cv_;
+  /** The thread running WarmUpInBackground, if any. */
+  std::thread warm_up_thread_;
+  /** Counters for GetMetrics. */
+  BufferPoolCounters counters_;
+  /** The most frames seen pinned by SamplePinnedFrames. */
+  size_t pinned_frames_high_water_{0};
+  /** Serializes Resize calls, and registration of the frames for read-ahead. */
+  std::mutex resize_latch_;
+  /** Whether the read-ahead worker should register the frames. */
+  bool register_frames_for_read_ahead_{false};
+  /** True once the frames are registered; they must not be released then. Protected by resize_latch_. */
+  bool frames_registered_{false};
+  /** Wakes a shrinking Resize when a frame it waits for may have been released. */
+  std::condition_variable resize_cv_;
+  /** Clean pages evicted from this instance, if enabled. */
+  std::unique_ptr<CompressedPageCache> compressed_cache_;
+  /** Loads pages ahead of sequential scans; created on first use. */
+  std::unique_ptr<ReadAheadWorker> read_ahead_worker_;
+  std::once_flag read_ahead_worker_created_;
+  /**
+   * Protects the page table, the free list, the free page map, io_in_progress_, the flusher state and the page_id_,
+   * pin_count_ and is_dirty_ metadata of every frame. It is never held across disk I/O or while waiting for a page
+   * latch.
+   */
   std::mutex latch_;
 };
 }  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A snapshot of the counters of a buffer pool. Counters only ever grow; subtract two snapshots to get the activity in
+ * between.
+ */
+struct BufferPoolMetrics {
+  /** FetchPage calls that found the page resident. */
+  uint64_t fetch_hits_{0};
+  /** FetchPage calls that did not find the page resident. */
+  uint64_t fetch_misses_{0};
+  /** Fetch misses served by the compressed page cache instead of the disk. */
+  uint64_t compressed_cache_hits_{0};
+  /** Pages created by NewPage. */
+  uint64_t new_pages_{0};
+  /** Pages evicted to make room for another one. */
+  uint64_t evictions_{0};
+  /** Dirty pages written back, by eviction, by flushes or by the background flusher. */
+  uint64_t dirty_write_backs_{0};
+  /** Times no frame could be found because every frame was pinned. */
+  uint64_t victim_failures_{0};
+  /** Total time callers spent waiting for the buffer pool latch, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+  /**
+   * The most frames seen pinned at the same time, looking whenever a frame was needed for another page and at every
+   * snapshot. Summed over instances, it is an upper bound for the whole pool.
+   */
+  uint64_t pinned_frames_high_water_{0};
+
+  /** @return the fraction of fetches that were hits, 0 if there were no fetches */
+  double HitRatio() const {
+    const uint64_t fetches = fetch_hits_ + fetch_misses_;
+    return fetches == 0 ? 0 : static_cast<double>(fetch_hits_) / static_cast<double>(fetches);
+  }
+
+  /** @return the fraction of fetches that did not read from disk, 0 if there were no fetches */
+  double EffectiveHitRatio() const {
+    const uint64_t fetches = fetch_hits_ + fetch_misses_;
+    return fetches == 0 ? 0 : static_cast<double>(fetch_hits_ + compressed_cache_hits_) / static_cast<double>(fetches);
+  }
+
+  BufferPoolMetrics &operator+=(const BufferPoolMetrics &other);
+};
+
+/**
+ * The counters behind BufferPoolMetrics, one set per buffer pool instance; a parallel buffer pool adds up those of its
+ * instances. Every event is counted while the instance holds its latch anyway, so an Add needs no atomic
+ * read-modify-write, only a plain load and store to a line that nobody but the latch holder writes. Snapshot may run
+ * concurrently with Add and needs no lock.
+ */
+class BufferPoolCounters {
+ public:
+  enum Counter : size_t {
+    FETCH_HITS,
+    FETCH_MISSES,
+    COMPRESSED_CACHE_HITS,
+    NEW_PAGES,
+    EVICTIONS,
+    DIRTY_WRITE_BACKS,
+    VICTIM_FAILURES,
+    LATCH_WAIT_NS,
+    NUM_COUNTERS
+  };
+
+  BufferPoolCounters() = default;
+
+  DISALLOW_COPY(BufferPoolCounters);
+
+  /** Add to a counter. Calls must not overlap; the caller serializes them with its own latch. */
+  void Add(Counter counter, uint64_t value = 1) {
+    counts_[counter].store(counts_[counter].load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  /** @return the value of every counter; pinned_frames_high_water_ is left 0 */
+  BufferPoolMetrics Snapshot() const;
+
+ private:
+  std::atomic<uint64_t> counts_[NUM_COUNTERS]{};
+};
+
+}  // namespace bustub
@@ -12,8 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
+#include <functional>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +23,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The replacer takes no locks. Each frame has an atomic state byte holding an "evictable" and a "referenced" flag;
+ * Pin and Unpin only flip those flags. Victim is the only operation that moves the clock hand: it clears the
+ * reference flag of each evictable frame it passes and claims the first evictable frame it finds unreferenced.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -39,14 +43,30 @@ class ClockReplacer : public Replacer {
 
   bool Victim(frame_id_t *frame_id) override;
 
+  bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) override;
+
   void Pin(frame_id_t frame_id) override;
 
   void Unpin(frame_id_t frame_id) override;
 
+  bool Evict(frame_id_t frame_id) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** The frame may be chosen as a victim. */
+  static constexpr uint8_t EVICTABLE = 0x1;
+  /** The frame was unpinned since the clock hand last passed it. */
+  static constexpr uint8_t REFERENCED = 0x2;
+
+  /** Number of frames tracked. */
+  const size_t capacity_;
+  /** Per-frame EVICTABLE | REFERENCED flags. */
+  std::vector<std::atomic<uint8_t>> states_;
+  /** Number of frames with the EVICTABLE flag set. */
+  std::atomic<size_t> size_{0};
+  /** Position of the clock hand; taken modulo capacity_. */
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
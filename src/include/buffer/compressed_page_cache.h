@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache keeps clean pages evicted from a buffer pool in compressed form, so that fetching one of them
+ * again costs a decompression instead of a disk read. Every page it holds is identical to the one on disk; the buffer
+ * pool erases a page from it whenever that might stop being true.
+ *
+ * The cache is bounded by the bytes its entries take, compressed data plus book-keeping. When an insertion goes over
+ * the capacity, the least recently inserted pages are dropped. A hit takes the page out of the cache, since the
+ * buffer pool holds it from then on. Compression and decompression run outside the cache latch.
+ */
+class CompressedPageCache {
+ public:
+  /** Pages that compress to more than this many bytes are not worth keeping. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE * 3 / 4;
+  /** Bytes of book-keeping charged to each entry, in addition to its compressed data. */
+  static constexpr size_t ENTRY_OVERHEAD = 64;
+
+  /**
+   * Creates a new CompressedPageCache.
+   * @param capacity the most bytes the cache may take
+   */
+  explicit CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * Compress a page and keep it, replacing any copy of it the cache holds already.
+   * @param page_id id of the page
+   * @param data the PAGE_SIZE bytes of the page
+   * @return false if the page does not compress well enough to be kept
+   */
+  bool Insert(page_id_t page_id, const char *data);
+
+  /**
+   * Take a page out of the cache.
+   * @param page_id id of the page
+   * @param[out] data the PAGE_SIZE bytes of the page
+   * @return false if the cache does not hold the page
+   */
+  bool Take(page_id_t page_id, char *data);
+
+  /** Drop a page from the cache, if it holds it. */
+  void Erase(page_id_t page_id);
+
+  /** @return the most bytes the cache may take */
+  size_t GetCapacity() const { return capacity_; }
+
+  /** @return the bytes the cache takes */
+  size_t GetSize();
+
+  /** @return the number of pages the cache holds */
+  size_t GetNumPages();
+
+  /** @return the number of pages dropped to make room for others */
+  size_t GetNumEvictions();
+
+ private:
+  struct Entry {
+    page_id_t page_id_;
+    std::unique_ptr<char[]> data_;
+    size_t size_;
+  };
+
+  /** Remove an entry. Caller must hold latch_. */
+  void RemoveEntry(std::list<Entry>::iterator it);
+
+  const size_t capacity_;
+  /** Entries, most recently inserted first. */
+  std::list<Entry> entries_;
+  std::unordered_map<page_id_t, std::list<Entry>::iterator> index_;
+  size_t size_{0};
+  size_t num_evictions_{0};
+  /** Protects everything above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
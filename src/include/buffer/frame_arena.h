@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is one contiguous, page-aligned block of memory that holds the data of every frame of a buffer pool.
+ * It is backed by 2 MiB huge pages when the system has them reserved (MAP_HUGETLB). Otherwise it falls back to
+ * ordinary pages and asks for transparent huge pages instead, which the kernel may or may not grant.
+ */
+class FrameArena {
+ public:
+  /** Size of a huge page; the arena is rounded up to a multiple of it. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * Creates a new FrameArena. The memory is zeroed.
+   * @param num_frames number of PAGE_SIZE frames in the arena
+   */
+  explicit FrameArena(size_t num_frames);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of a frame */
+  inline char *GetFrameData(frame_id_t frame_id) { return base_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Give the memory of every frame from first_frame_id on back to the operating system. The frames stay mapped and
+   * read as zeros when next touched. Only whole pages of the arena can be given back, so with huge pages up to 2 MiB
+   * from first_frame_id on may stay resident.
+   * @param first_frame_id the first frame no longer in use
+   */
+  void ReleaseFrom(frame_id_t first_frame_id);
+
+  /** @return the size of the arena, a multiple of HUGE_PAGE_SIZE; GetFrameData(0) is where it starts */
+  inline size_t GetSize() const { return size_; }
+
+  /** @return true if the arena is backed by explicitly reserved huge pages */
+  inline bool IsHugePageBacked() const { return huge_pages_; }
+
+ private:
+  char *base_;
+  /** Length of the mapping. */
+  size_t size_;
+  bool huge_pages_{false};
+};
+
+}  // namespace bustub
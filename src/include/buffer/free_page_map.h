@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/buffer/free_page_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * FreePageMap is a bitmap of deallocated pages. It knows nothing of page ids: a buffer pool instance numbers the pages
+ * of its own stripe 0, 1, 2, ... and uses those slot numbers, so that whatever it takes from the map still belongs to
+ * its stripe. It is not thread safe; the instance guards it with its latch.
+ */
+class FreePageMap {
+ public:
+  FreePageMap() = default;
+
+  /**
+   * Mark a slot as free.
+   * @param slot the slot
+   * @param num_slots the number of slots handed out so far; a slot past them was never in use and is not freed
+   * @return false if the slot was free already or was never handed out
+   */
+  bool Free(size_t slot, size_t num_slots);
+
+  /**
+   * Take the lowest free slot, so that the file fills up from the front.
+   * @param[out] slot the slot
+   * @return false if no slot is free
+   */
+  bool Take(size_t *slot);
+
+  /**
+   * Take the lowest free slot that accept approves of.
+   * @param[out] slot the slot
+   * @param accept tells whether a free slot will do
+   * @return false if no free slot will do
+   */
+  bool Take(size_t *slot, const std::function<bool(size_t)> &accept);
+
+  /** @return the number of free slots */
+  size_t NumFree() const { return num_free_; }
+
+  /** @return the bitmap, one bit per slot, bit i of word i / 64 for slot i */
+  const std::vector<uint64_t> &GetWords() const { return words_; }
+
+  /** Replace the whole bitmap, e.g. with one read back from disk. */
+  void SetWords(std::vector<uint64_t> words);
+
+ private:
+  std::vector<uint64_t> words_;
+  size_t num_free_{0};
+  /** No word below this one has a free slot. */
+  size_t first_free_word_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy (O'Neil et al., SIGMOD '93).
+ *
+ * Every Pin counts as one access to the frame. The victim is the evictable frame whose backward K-distance, i.e. the
+ * time since its K-th most recent access, is the largest. Frames with fewer than K recorded accesses have an infinite
+ * backward K-distance and are evicted first, in order of their earliest access. A single sequential scan therefore
+ * only ever evicts other once-touched pages and cannot flush out a hot set that has been referenced K times.
+ *
+ * Accesses that arrive within the correlated reference period of the previous access to the same frame are treated as
+ * part of one burst: they refresh the last access time but do not add a new entry to the history. Once the burst is
+ * over, its entry and the older ones are shifted forward by its length, as in O'Neil et al.'s LRU-K, so the burst
+ * counts as a reference made at its end. A frame whose last access is still inside the correlated reference period is
+ * not eligible for eviction unless no other frame is.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses tracked per frame
+   * @param correlated_period accesses closer together than this many ticks (Pin calls) count as one reference
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        size_t correlated_period = LRUK_CORRELATED_REFERENCE_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  bool Evict(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** Per-frame access bookkeeping. */
+  struct FrameInfo {
+    /** Number of valid entries in the history (at most k_). */
+    size_t count_{0};
+    /** Ring slot holding the most recent history entry. */
+    size_t head_{0};
+    /** Time of the last access, correlated or not. */
+    size_t last_access_{0};
+    /** Eviction key this frame is filed under while evictable. */
+    std::pair<size_t, frame_id_t> key_{0, 0};
+    /** True if the frame is in one of the eviction sets. */
+    bool evictable_{false};
+  };
+
+  /** @return the i-th most recent uncorrelated access of the frame, i = 0 being the latest */
+  size_t &History(frame_id_t frame_id, size_t i);
+
+  /** Record an access to the frame at the current timestamp. */
+  void RecordAccess(frame_id_t frame_id);
+
+  /** Drop the frame from whichever eviction set holds it. Caller must hold latch_. */
+  void RemoveEvictable(frame_id_t frame_id);
+
+  /** Number of frames tracked. */
+  const size_t capacity_;
+  /** K, the number of accesses remembered per frame. */
+  const size_t k_;
+  /** Length of the correlated reference period, in ticks. */
+  const size_t correlated_period_;
+  /** Logical clock, advanced on every access. */
+  size_t current_timestamp_{0};
+  /** Bookkeeping for each frame. */
+  std::vector<FrameInfo> frames_;
+  /** Flattened k_-entry history ring per frame. */
+  std::vector<size_t> history_;
+  /** Evictable frames with fewer than k_ accesses, ordered by earliest access. */
+  std::set<std::pair<size_t, frame_id_t>> infant_frames_;
+  /** Evictable frames with k_ accesses, ordered by K-th most recent access. */
+  std::set<std::pair<size_t, frame_id_t>> mature_frames_;
+  /** Protects all of the above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,7 +12,7 @@
 
 #pragma once
 
-#include <list>
+#include <functional>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -23,6 +23,9 @@ namespace bustub {
 
 /**
  * LRUReplacer implements the Least Recently Used replacement policy.
+ *
+ * The LRU order is kept in an intrusive doubly-linked list threaded through a preallocated array indexed by frame id,
+ * so Victim, Pin and Unpin are all O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -39,18 +42,35 @@ class LRUReplacer : public Replacer {
 
   bool Victim(frame_id_t *frame_id) override;
 
+  bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) override;
+
   void Pin(frame_id_t frame_id) override;
 
   void Unpin(frame_id_t frame_id) override;
 
+  bool Evict(frame_id_t frame_id) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
-  size_t max_pages_num;
-  std::list<frame_id_t> lru_list;
-  std::mutex mtx;
+  /** Link slots of one frame in the LRU list. */
+  struct ListNode {
+    frame_id_t prev_;
+    frame_id_t next_;
+    bool in_list_;
+  };
+
+  /** Unlink a frame that is currently in the list. Caller must hold latch_. */
+  void Remove(frame_id_t frame_id);
 
+  /** Maximum number of frames tracked; also the index of the list head sentinel in nodes_. */
+  const frame_id_t capacity_;
+  /** One node per frame plus the sentinel. nodes_[capacity_].next_ is the LRU end, .prev_ the MRU end. */
+  std::vector<ListNode> nodes_;
+  /** Number of frames currently in the list. */
+  size_t size_{0};
+  /** Protects nodes_ and size_. */
+  std::mutex latch_;
 };
 
 }  // namespace bustub
@@ -12,7 +12,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -27,18 +33,45 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used by every BufferPoolManagerInstance
+   * @param max_pool_size the largest size Resize may grow each BufferPoolManagerInstance to; 0 for pool_size
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t max_pool_size = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
    */
   ~ParallelBufferPoolManager() override;
 
+  /** Save the free page map of every instance; each has a record of its own in the header page. */
+  void SaveFreePageMap(HeaderPage *header_page) override;
+
+  /**
+   * Load the free page map of every instance.
+   * @return false if some instance has no saved map
+   */
+  bool LoadFreePageMap(HeaderPage *header_page) override;
+
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * Resize every instance, spreading pool_size over them as evenly as possible.
+   * @param pool_size the new total size of the buffer pool
+   * @return false if some instance cannot take its share; the instances are left untouched then
+   */
+  bool Resize(size_t pool_size) override;
+
+  /** @return the sum of the metrics of every instance */
+  BufferPoolMetrics GetMetrics() override;
+
+  bool IsPageDirty(page_id_t page_id) override { return GetBufferPoolManager(page_id)->IsPageDirty(page_id); }
+
+  std::shared_ptr<ReadAheadRequest> ReadAhead(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                                              std::shared_ptr<BufferAccessStrategy> strategy) override;
+
  protected:
   /**
    * @param page_id id of page
@@ -53,6 +86,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool on behalf of a bulk operation.
+   * @param page_id id of page to be fetched
+   * @param strategy the bulk operation's ring; nullptr for an ordinary fetch
+   * @return the requested page
+   */
+  Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -75,6 +116,23 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool on behalf of a bulk operation.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Creates a new page in the buffer pool, preferably in the given data file.
+   * @param[out] page_id id of created page
+   * @param strategy the bulk operation's ring; nullptr for an ordinary new page
+   * @param data_file the data file the page should live in; ANY_DATA_FILE for no preference
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, BufferAccessStrategy *strategy, data_file_id_t data_file) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -86,5 +144,34 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   void FlushAllPgsImp() override;
+
+  /**
+   * Load a page into the buffer pool without pinning it.
+   * @param page_id id of the page to load
+   * @param next_page how to find the page that follows this one
+   * @param[out] next_page_id the page that follows
+   * @param strategy the ring to load the page into, if any
+   * @return false if the page could not be loaded
+   */
+  bool PrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id,
+                     BufferAccessStrategy *strategy) override;
+
+  /** Start loading the page in the instance that owns it. */
+  PrefetchStatus StartPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, AsyncIo *io,
+                                    uint64_t tag, BufferAccessStrategy *strategy) override;
+
+  /** Finish loading the page in the instance that owns it. */
+  void FinishPrefetchPgImp(page_id_t page_id, next_page_fn next_page, page_id_t *next_page_id, bool ok) override;
+
+ private:
+  /** The disk manager shared by the instances. */
+  DiskManager *disk_manager_;
+  /** The individual buffer pool instances; page_id % num_instances picks the one owning a page. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** Instance at which the next NewPgImp starts its search, taken modulo the number of instances. */
+  std::atomic<size_t> next_instance_{0};
+  /** Loads pages ahead of sequential scans, which hop between instances; created on first use. */
+  std::unique_ptr<ReadAheadWorker> read_ahead_worker_;
+  std::once_flag read_ahead_worker_created_;
 };
 }  // namespace bustub
@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.h
+//
+// Identification: src/include/buffer/read_ahead_worker.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/async_io.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/** Given the contents of a page, return the id of the page that follows it in a chain (or INVALID_PAGE_ID). */
+using next_page_fn = page_id_t (*)(const char *page_data);
+
+/**
+ * A read-ahead request: load up to remaining_ pages of a page chain, starting at next_page_id_.
+ */
+struct ReadAheadRequest {
+  ReadAheadRequest(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                   std::shared_ptr<BufferAccessStrategy> strategy)
+      : next_page_id_(first_page_id), remaining_(num_pages), next_page_(next_page), strategy_(std::move(strategy)) {}
+
+  /** The next page of the chain to load. Only touched by the worker. */
+  page_id_t next_page_id_;
+  /** How many more pages to load. Only touched by the worker. */
+  size_t remaining_;
+  /** True while the read of next_page_id_ is in flight. Only touched by the worker. */
+  bool reading_{false};
+  /** Follows the chain from one page to the next. */
+  next_page_fn next_page_;
+  /** The ring of the scan the pages are loaded for, if it has one. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** Set by the requester when it no longer needs the pages, e.g. because the scan stopped. */
+  std::atomic<bool> cancelled_{false};
+  /** Set by the worker once it is done with the request. */
+  std::atomic<bool> finished_{false};
+};
+
+/**
+ * ReadAheadWorker loads chains of pages into a buffer pool from a background thread, so that a sequential scan finds
+ * its next pages resident instead of waiting for one dependent read after another. Pages are loaded unpinned, via
+ * BufferPoolManager::StartPrefetchPage; the worker never evicts a dirty page to make room and simply drops a request
+ * when the pool has no free or clean frame to spare.
+ *
+ * Within a chain, the id of a page is only known once its predecessor has been read, so each request has at most one
+ * read in flight. The worker works on up to the queue depth of its AsyncIo requests at once instead, so that the
+ * reads of concurrent scans overlap.
+ */
+class ReadAheadWorker {
+ public:
+  /**
+   * Creates a new ReadAheadWorker. The thread is started on the first Submit.
+   * @param bpm the buffer pool to load pages into
+   * @param io the AsyncIo the worker thread reads with
+   */
+  ReadAheadWorker(BufferPoolManager *bpm, std::unique_ptr<AsyncIo> io);
+
+  /** Cancels everything outstanding and joins the thread. */
+  ~ReadAheadWorker();
+
+  DISALLOW_COPY_AND_MOVE(ReadAheadWorker);
+
+  /**
+   * Queue a read-ahead request.
+   * @param first_page_id the first page to load
+   * @param num_pages the number of pages to load, following the chain
+   * @param next_page how to find the page after a given one
+   * @param strategy the ring to load the pages into, if any
+   * @return the request; set its cancelled_ flag to stop it
+   */
+  std::shared_ptr<ReadAheadRequest> Submit(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                                           std::shared_ptr<BufferAccessStrategy> strategy);
+
+ private:
+  /** Body of the worker thread. */
+  void Run();
+
+  /** Load pages of a request until it has a read in flight or is done. Called by the worker thread. */
+  void Advance(ReadAheadRequest *request);
+
+  /** @return true if the worker is done with a request */
+  static bool IsDone(const ReadAheadRequest &request) {
+    return request.remaining_ == 0 || request.next_page_id_ == INVALID_PAGE_ID || request.cancelled_;
+  }
+
+  BufferPoolManager *bpm_;
+  std::unique_ptr<AsyncIo> io_;
+  std::deque<std::shared_ptr<ReadAheadRequest>> queue_;
+  std::thread thread_;
+  bool running_{false};
+  /** Protects queue_, thread_ and running_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+};
+
+}  // namespace bustub
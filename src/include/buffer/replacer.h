@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <functional>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a buffer pool can be configured with. */
+enum class ReplacerType { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -31,6 +36,15 @@ class Replacer {
    */
   virtual bool Victim(frame_id_t *frame_id) = 0;
 
+  /**
+   * Remove the victim frame as defined by the replacement policy, among the frames accept approves of. The others stay
+   * where they are, as if they had not been looked at.
+   * @param[out] frame_id id of frame that was removed
+   * @param accept tells whether an evictable frame may be taken
+   * @return true if an acceptable victim frame was found, false otherwise
+   */
+  virtual bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &accept) = 0;
+
   /**
    * Pins a frame, indicating that it should not be victimized until it is unpinned.
    * @param frame_id the id of the frame to pin
@@ -43,6 +57,13 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Remove a particular frame, as if Victim had picked it.
+   * @param frame_id the id of the frame to remove
+   * @return false if the frame was not evictable
+   */
+  virtual bool Evict(frame_id_t frame_id) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
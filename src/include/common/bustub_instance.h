@@ -23,7 +23,13 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file
+   * @param pool_size the initial size of the buffer pool
+   * @param max_pool_size the largest size the buffer pool may be resized to; 0 for pool_size
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t pool_size = BUFFER_POOL_SIZE,
+                          size_t max_pool_size = 0) {
     enable_logging = false;
 
     // storage related
@@ -32,7 +38,8 @@ class BustubInstance {
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    buffer_pool_manager_ = new BufferPoolManagerInstance(pool_size, disk_manager_, log_manager_, ReplacerType::LRU,
+                                                         max_pool_size);
 
     // txn related
     lock_manager_ = new LockManager();
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,20 +28,41 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The buffer pool's background flusher, when running, looks for dirty pages at least this often. */
+extern std::chrono::milliseconds background_flush_interval;
+
+/** A shrinking buffer pool checks at least this often whether the pinned frames it has to give up are free yet. */
+extern std::chrono::milliseconds resize_retry_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
+static constexpr int ANY_DATA_FILE = -1;                                      // no preference for a data file
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr size_t CACHE_LINE_SIZE = 64;                                  // size of a CPU cache line in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr size_t LRUK_REPLACER_K = 2;                                  // K for the LRU-K replacer
+static constexpr size_t LRUK_CORRELATED_REFERENCE_PERIOD = 0;                 // LRU-K correlated period, in accesses
+static constexpr size_t READ_AHEAD_PAGES = 8;                                  // pages read ahead of a table scan
+static constexpr size_t READ_AHEAD_TRIGGER = 2;                                // table scan pages before read-ahead
+static constexpr size_t BUFFER_ACCESS_STRATEGY_RING_SIZE = 16;                 // frames recycled by a bulk scan or load
+static constexpr size_t LARGE_TABLE_POOL_FRACTION = 4;                         // tables over 1/4 of the pool use a ring
+static constexpr size_t FLUSH_MAX_BATCH_PAGES = 64;                            // most pages per batch of a full flush
+static constexpr size_t WARM_UP_MAX_RUN_PAGES = 64;                            // most pages per read of a warm-up
+static constexpr size_t ASYNC_IO_QUEUE_DEPTH = 32;                             // I/Os in flight per flusher/read-ahead
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;                            // buffer alignment O_DIRECT requires
+static constexpr size_t DB_FILE_EXTENT_SIZE = 64 * 1024 * 1024;                // bytes the db file is preallocated by
+static constexpr size_t DATA_FILE_STRIPE_PAGES = 16;                           // pages per stripe of a multi-file db
 
-using frame_id_t = int32_t;    // frame id type
-using page_id_t = int32_t;     // page id type
-using txn_id_t = int32_t;      // transaction id type
-using lsn_t = int32_t;         // log sequence number type
-using slot_offset_t = size_t;  // slot offset type
+using frame_id_t = int32_t;      // frame id type
+using page_id_t = int32_t;       // page id type
+using txn_id_t = int32_t;        // transaction id type
+using lsn_t = int32_t;           // log sequence number type
+using slot_offset_t = size_t;    // slot offset type
+using data_file_id_t = int32_t;  // data file id type
 using oid_t = uint16_t;
 
 }  // namespace bustub
@@ -12,25 +12,26 @@
 
 #pragma once
 
-#include <climits>
-#include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
+#include "common/config.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch built on a single atomic word.
+ *
+ * An uncontended RLock or WLock is one compare-and-swap. A thread that cannot get the latch spins for a while, then
+ * parks on the word with a futex (or yields, where futexes are not available) until an unlock wakes it. A waiting
+ * writer stops new readers from entering, so writers are not starved by a steady stream of readers.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
-
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,13 +39,9 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    uint32_t state = 0;
+    if (!state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed)) {
+      WLockSlow();
     }
   }
 
@@ -52,45 +49,118 @@ class ReaderWriterLatch {
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    uint32_t state = state_.fetch_and(~(WRITER | PARKED), std::memory_order_release);
+    if ((state & PARKED) != 0) {
+      WakeAll(&state_);
+    }
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & (WRITER | WRITER_WAITING)) != 0 || (state & READERS) == READERS ||
+        !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+      RLockSlow();
     }
-    reader_count_++;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    uint32_t next;
+    do {
+      // The last reader out wakes whoever is parked: a writer waiting for the readers to drain, and the readers that
+      // queued up behind it.
+      next = state - 1;
+      if ((next & READERS) == 0) {
+        next &= ~PARKED;
       }
+    } while (!state_.compare_exchange_weak(state, next, std::memory_order_release, std::memory_order_relaxed));
+    if ((state & PARKED) != 0 && (next & PARKED) == 0) {
+      WakeAll(&state_);
     }
   }
 
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  friend class PerCoreReaderWriterLatch;
+
+  /** Set while a writer holds the latch. */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a writer waits for the latch; keeps new readers out. */
+  static constexpr uint32_t WRITER_WAITING = 1U << 30;
+  /** Set when some thread may be parked on the latch, so the next unlock must wake it. */
+  static constexpr uint32_t PARKED = 1U << 29;
+  /** The number of readers holding the latch. */
+  static constexpr uint32_t READERS = PARKED - 1;
+  /** How many times to retry before parking. */
+  static constexpr int SPIN_LIMIT = 64;
+
+  void WLockSlow();
+  void RLockSlow();
+
+  /** Give the CPU to the other hyperthread, or simply wait a little, while spinning. */
+  static void CpuRelax();
+
+  /** Sleep while *word still equals expected. May return spuriously. */
+  static void Wait(std::atomic<uint32_t> *word, uint32_t expected);
+
+  /** Wake every thread sleeping on word. */
+  static void WakeAll(std::atomic<uint32_t> *word);
+
+  std::atomic<uint32_t> state_{0};
+};
+
+/**
+ * Reader-Writer latch for latches that are read latched far more often than write latched by many threads at once,
+ * like a table latch. Each reader only touches a counter on the cache line of the CPU it runs on, so readers on
+ * different cores do not contend with one another. In exchange a writer has to scan every counter, and the latch
+ * takes one cache line per CPU, so it is not meant for per-page latches.
+ */
+class PerCoreReaderWriterLatch {
+ public:
+  PerCoreReaderWriterLatch();
+  ~PerCoreReaderWriterLatch() = default;
+
+  DISALLOW_COPY(PerCoreReaderWriterLatch);
+
+  /** Acquire a write latch. */
+  void WLock();
+
+  /** Release a write latch. */
+  void WUnlock();
+
+  /** Acquire a read latch. */
+  void RLock();
+
+  /** Release a read latch. */
+  void RUnlock();
+
+ private:
+  /** Values of writer_ besides 0. */
+  static constexpr uint32_t WRITER_HELD = 1;
+  static constexpr uint32_t WRITER_PARKED = 2;
+
+  /** A reader count on a cache line of its own. It may go negative when a reader migrates between RLock and RUnlock. */
+  struct alignas(CACHE_LINE_SIZE) Counter {
+    std::atomic<int64_t> count_{0};
+  };
+
+  /** @return the counter of the CPU the calling thread is running on */
+  Counter *CurrentCounter();
+
+  /** Number of counters, a power of two. */
+  size_t num_counters_;
+  std::unique_ptr<Counter[]> counters_;
+  /** Nonzero while a writer holds or is acquiring the latch, WRITER_PARKED once a reader parks on it. */
+  std::atomic<uint32_t> writer_{0};
+  /** Bumped by readers leaving while writer_ is set; the writer parks on it while readers drain. */
+  std::atomic<uint32_t> drained_{0};
+  /** Serializes writers. */
+  ReaderWriterLatch writer_latch_;
 };
 
 }  // namespace bustub
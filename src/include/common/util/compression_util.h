@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.h
+//
+// Identification: src/include/common/util/compression_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CompressionUtil is a small LZ77 codec in the style of LZ4, for data of up to 64 KiB such as pages. It trades
+ * ratio for speed: matches are found through a single hash table probe, and the output is a sequence of
+ * (literals, back-reference) pairs that decompresses with plain copies.
+ *
+ * Format of a sequence:
+ *  ---------------------------------------------------------------------------------------------------------------
+ * | Token (1) | Literal length (0+) | Literals | Offset (2, little endian) | Match length (0+) |
+ *  ---------------------------------------------------------------------------------------------------------------
+ *
+ * The high nibble of the token is the number of literals, the low nibble the match length minus 4. A nibble of 15
+ * is continued by bytes that are added to it, up to and including the first one below 255. The last sequence has
+ * literals only, and ends the input.
+ */
+class CompressionUtil {
+ public:
+  /** @return the largest size Compress can produce for src_size bytes of input */
+  static constexpr size_t MaxCompressedSize(size_t src_size) { return src_size + src_size / 255 + 16; }
+
+  /**
+   * Compress a block of data.
+   * @param src the data, at most 64 KiB of it
+   * @param src_size size of the data
+   * @param[out] dst the compressed data
+   * @param dst_capacity size of dst
+   * @return the size of the compressed data, 0 if it does not fit in dst_capacity
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompress a block of data produced by Compress.
+   * @param src the compressed data
+   * @param src_size size of the compressed data
+   * @param[out] dst the data
+   * @param dst_size size of the data before compression
+   * @return false if src is not a valid compressed block of dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+
+ private:
+  static constexpr size_t MIN_MATCH = 4;
+  static constexpr size_t MAX_OFFSET = 65535;
+  static constexpr size_t HASH_BITS = 12;
+};
+
+}  // namespace bustub
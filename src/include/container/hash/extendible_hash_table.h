@@ -40,9 +40,11 @@ class ExtendibleHashTable {
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param data_file the data file the table's pages should live in, if the database has several
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               data_file_id_t data_file = ANY_DATA_FILE);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -167,8 +169,9 @@ class ExtendibleHashTable {
   KeyComparator comparator_;
 
   // Readers includes inserts and removes, writers are splits and merges
-  ReaderWriterLatch table_latch_; 
+  PerCoreReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  data_file_id_t data_file_;
 };
 
 }  // namespace bustub
@@ -15,6 +15,7 @@
 #include <memory>
 #include <utility>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/insert_plan.h"
@@ -64,6 +65,8 @@ class InsertExecutor : public AbstractExecutor {
   uint32_t rawIdx_;
   TableHeap* tableHeap_;
   TableInfo* tableInfo_;
+  /** Ring of frames for bulk loads, so that they do not flush the rest of the buffer pool; nullptr for small inserts */
+  std::unique_ptr<BufferAccessStrategy> bulkStrategy_;
 };
 
 }  // namespace bustub
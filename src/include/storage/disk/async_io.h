@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io.h
+//
+// Identification: src/include/storage/disk/async_io.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class DiskManager;
+
+/** The outcome of an asynchronous page read or write. */
+struct IoCompletion {
+  /** The tag the request was queued with. */
+  uint64_t tag_;
+  /** False if the page could not be transferred. */
+  bool ok_;
+};
+
+/**
+ * AsyncIo reads and writes pages of a DiskManager's database file without waiting for each transfer to finish, so
+ * that a single thread can keep many of them in flight. Requests are queued with QueueRead and QueueWrite, handed
+ * over as one batch by Submit, and collected with Reap. An AsyncIo belongs to one thread; every thread that does
+ * asynchronous I/O creates its own with DiskManager::CreateAsyncIo.
+ *
+ * This class is the fallback for systems without an asynchronous I/O interface: Submit performs the requests one
+ * after another through the DiskManager's ReadPage and WritePage, so Reap never waits.
+ */
+class AsyncIo {
+ public:
+  /**
+   * Creates a new AsyncIo.
+   * @param disk_manager the disk manager whose database file is read and written
+   * @param queue_depth the most requests that may be queued and in flight at the same time
+   */
+  AsyncIo(DiskManager *disk_manager, size_t queue_depth) : disk_manager_(disk_manager), queue_depth_(queue_depth) {}
+
+  virtual ~AsyncIo() = default;
+
+  DISALLOW_COPY_AND_MOVE(AsyncIo);
+
+  /** @return the most requests that may be queued and in flight at the same time */
+  size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return the number of requests queued or in flight, i.e. not reaped yet */
+  size_t GetNumPending() const { return queued_.size() + num_in_flight_; }
+
+  /**
+   * Queue the read of a page. The page reads as zeros past the end of the file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the request is reaped
+   * @param tag reported back by Reap
+   */
+  void QueueRead(page_id_t page_id, char *page_data, uint64_t tag) { Queue(false, page_id, page_data, tag); }
+
+  /**
+   * Queue the write of a page.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay valid and unchanged until the request is reaped
+   * @param tag reported back by Reap
+   */
+  void QueueWrite(page_id_t page_id, const char *page_data, uint64_t tag) {
+    Queue(true, page_id, const_cast<char *>(page_data), tag);
+  }
+
+  /**
+   * Register a block of memory with the kernel up front, so that transfers to and from it skip mapping it for every
+   * request. The memory stays pinned for the lifetime of the AsyncIo, and must stay mapped to the same pages: don't
+   * madvise it away. Call before queueing anything.
+   * @param data the block, e.g. a buffer pool's frame arena
+   * @param size size of the block
+   * @return false if registration is not supported or failed; requests then work as before
+   */
+  virtual bool RegisterBuffers(char *data, size_t size) { return false; }
+
+  /** Start every queued request. */
+  virtual void Submit();
+
+  /**
+   * Collect finished requests, waiting until at least min_completions of them have finished.
+   * @param[out] completions the finished requests are appended to it
+   * @param min_completions how many to wait for; capped at the number of requests in flight
+   * @return the number of requests appended
+   */
+  virtual size_t Reap(std::vector<IoCompletion> *completions, size_t min_completions);
+
+ protected:
+  struct Request {
+    bool is_write_;
+    page_id_t page_id_;
+    char *page_data_;
+    uint64_t tag_;
+  };
+
+  void Queue(bool is_write, page_id_t page_id, char *page_data, uint64_t tag) {
+    BUSTUB_ASSERT(GetNumPending() < queue_depth_, "AsyncIo queue depth exceeded");
+    queued_.push_back(Request{is_write, page_id, page_data, tag});
+  }
+
+  DiskManager *disk_manager_;
+  const size_t queue_depth_;
+  /** Requests queued since the last Submit. */
+  std::vector<Request> queued_;
+  /** Requests submitted and not reaped yet. */
+  size_t num_in_flight_{0};
+  /** Requests the fallback has completed, waiting to be reaped. */
+  std::vector<IoCompletion> completed_;
+};
+
+}  // namespace bustub
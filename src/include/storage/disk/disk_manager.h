@@ -12,29 +12,82 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 #include <atomic>
-#include <fstream>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/async_io.h"
+#include "storage/disk/mapped_pages.h"
 
 namespace bustub {
 
+/**
+ * When DiskManager waits for what it writes to reach stable storage. Under every policy the log file and the database
+ * file are written with plain positional writes, which no longer cost a flush each; the policy only decides where the
+ * fdatasync barriers go.
+ */
+enum class DurabilityPolicy {
+  /** Never sync. A crash can lose or reorder anything; for throughput testing only. */
+  NO_SYNC,
+  /**
+   * Sync the log on every WriteLog, before it returns, so the log reaches disk ahead of the pages it describes. Data
+   * pages are written lazily and only synced by Sync, e.g. at a checkpoint or at the end of FlushAllPages.
+   */
+  SYNC_LOG,
+  /** Like SYNC_LOG, and also sync after every WritePage and WritePages call. */
+  SYNC_ALL,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O on a file descriptor, so there is no shared file cursor and no latch:
+ * requests for different pages run in parallel, and it is up to the caller not to read and write the same page at the
+ * same time.
+ *
+ * The database can be a tablespace of several data files, e.g. on different devices. Pages are striped across them
+ * round-robin, stripe_pages consecutive page ids at a time: page p lives in data file (p / stripe_pages) % N. Which
+ * pages an object gets, and so which file it lives in, is up to whoever allocates page ids; GetDataFile tells it. The
+ * layout is not recorded anywhere, so a database must always be opened with the same files in the same order and
+ * the same stripe size. Each data file has its own I/O queue, a thread that runs its share of a batch that spans
+ * several files, so that all of them are busy at once.
+ *
+ * In direct I/O mode the database file bypasses the operating system's page cache, so that a page held by the buffer
+ * pool is not cached a second time by the kernel. Direct I/O needs buffers aligned to DIRECT_IO_ALIGNMENT; buffer
+ * pool frames are, and any other buffer goes through an aligned copy. The log file is always written through the
+ * page cache: its writes are small and sequential, and the log manager does not hand us aligned buffers.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io open the database file with O_DIRECT; if the file system refuses, the file is opened normally
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
-  ~DiskManager() = default;
+  /**
+   * Creates a new disk manager for a database made of several data files.
+   * @param db_files the file names of the data files; the log file is named after the first
+   * @param stripe_pages how many consecutive page ids go to one data file before moving on to the next
+   * @param direct_io open the data files with O_DIRECT where the file system allows
+   */
+  DiskManager(const std::vector<std::string> &db_files, size_t stripe_pages, bool direct_io = false);
+
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -46,17 +99,75 @@ class DiskManager {
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
+
+  /**
+   * Write a run of consecutive pages to the database file, with one vectored write for up to IOV_MAX pages. Call Sync
+   * once the last run is written.
+   * @param first_page_id id of the first page of the run
+   * @param pages_data raw data of each page of the run
+   * @param num_pages number of pages in the run
+   */
+  virtual void WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages);
 
   /**
-   * Read a page from the database file.
+   * Wait until every page written so far is on stable storage. Does nothing under DurabilityPolicy::NO_SYNC.
+   */
+  virtual void Sync();
+
+  /**
+   * Read a page from the database file. A page past the end of the file reads as zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read a run of consecutive pages from the database file, with one vectored read for up to IOV_MAX pages. Pages
+   * past the end of the file read as zeros.
+   * @param first_page_id id of the first page of the run
+   * @param[out] pages_data output buffer of each page of the run
+   * @param num_pages number of pages in the run
+   */
+  virtual void ReadPages(page_id_t first_page_id, char *const *pages_data, size_t num_pages);
+
+  /**
+   * Write a batch of pages. Entries with consecutive page ids next to each other in the batch are written as one run
+   * by WritePages, so sort the batch by page id for the fewest system calls.
+   * @param pages the id and raw data of each page
+   * @param num_pages number of pages in the batch
+   * @param sync if true, Sync once every page is written
+   */
+  void WritePageBatch(const std::pair<page_id_t, const char *> *pages, size_t num_pages, bool sync);
 
   /**
-   * Flush the entire log buffer into disk.
+   * Read a batch of pages. Entries with consecutive page ids next to each other in the batch are read as one run by
+   * ReadPages. Pages past the end of the file read as zeros.
+   * @param pages the id and output buffer of each page
+   * @param num_pages number of pages in the batch
+   */
+  void ReadPageBatch(const std::pair<page_id_t, char *> *pages, size_t num_pages);
+
+  /**
+   * Create an AsyncIo for reading and writing pages without waiting for each one, on an io_uring where the system
+   * has one. The synchronous interface above is unaffected. A subclass that intercepts ReadPage or WritePage can
+   * return a plain AsyncIo, which goes through them.
+   * @param queue_depth the most requests that may be queued and in flight at the same time
+   * @return an AsyncIo for the calling thread
+   */
+  virtual std::unique_ptr<AsyncIo> CreateAsyncIo(size_t queue_depth);
+
+  /**
+   * Map the data files read-only, for scans that read pages in place rather than through the buffer pool. The mapping
+   * sees every page written through the disk manager, before or after it was made, but not what the buffer pool holds
+   * dirty.
+   * @return the mapping, to be destroyed before the disk manager
+   */
+  std::unique_ptr<MappedPages> MapPages();
+
+  /**
+   * Flush the entire log buffer into disk. Unless the policy is DurabilityPolicy::NO_SYNC, the log is synced before
+   * this returns, once for the whole buffer: commits that share a log buffer share the sync.
    * @param log_data raw log data
    * @param size size of log entry
    */
@@ -80,6 +191,41 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of data files */
+  size_t GetNumDataFiles() const { return data_files_.size(); }
+
+  /** @return how many consecutive page ids go to one data file */
+  size_t GetStripePages() const { return stripe_pages_; }
+
+  /** @return the data file a page lives in, 0 to GetNumDataFiles() - 1 */
+  data_file_id_t GetDataFile(page_id_t page_id) const {
+    return static_cast<data_file_id_t>(static_cast<size_t>(page_id) / stripe_pages_ % data_files_.size());
+  }
+
+  /** @return one past the highest page id on disk, in whichever data file it lives */
+  page_id_t GetNumPages() const;
+
+  /** Set when the database and log files are synced. Call before any other thread uses the disk manager. */
+  void SetDurabilityPolicy(DurabilityPolicy policy) { durability_policy_ = policy; }
+
+  /** @return when the database and log files are synced */
+  DurabilityPolicy GetDurabilityPolicy() const { return durability_policy_; }
+
+  /**
+   * Set how the database file grows. Rather than by a page at a time as pages are first written, it is preallocated a
+   * whole extent at a time with fallocate, which keeps the file contiguous and spares the file system a metadata
+   * update for every new page. The preallocated space does not count towards the size of the file until it is written.
+   * Call before any other thread uses the disk manager.
+   * @param extent_size bytes to preallocate at a time, a multiple of PAGE_SIZE; 0 to turn preallocation off
+   */
+  void SetExtentSize(size_t extent_size) { extent_size_ = extent_size; }
+
+  /** @return the bytes preallocated at a time; 0 if the file grows a page at a time */
+  size_t GetExtentSize() const { return extent_size_; }
+
+  /** @return true if the data files are read and written with direct I/O */
+  bool IsDirectIo() const { return direct_io_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,19 +236,108 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  friend class IoUringAsyncIo;
+  friend class MappedPages;
+
+  /** One file of the tablespace. */
+  struct DataFile {
+    int fd_{-1};
+    // size of the file, up to the last page written; kept here so nothing has to stat the file
+    std::atomic<off_t> size_{0};
+    // end of the space preallocated for the file, which may be ahead of size_; not known past size_ for a file opened
+    // again, whose preallocation is then redone, at no cost
+    std::atomic<off_t> allocated_size_{0};
+    // serializes preallocation
+    std::mutex allocation_latch_;
+    // the file's I/O queue, drained by io_thread_; only used when there are several data files
+    std::deque<std::packaged_task<void()>> io_queue_;
+    std::mutex io_queue_latch_;
+    std::condition_variable io_queue_cv_;
+    bool io_thread_running_{false};
+    std::thread io_thread_;
+  };
+
+  /** @return the data file a page lives in */
+  DataFile *FileOf(page_id_t page_id) const { return data_files_[GetDataFile(page_id)].get(); }
+
+  /** @return the offset of a page in its data file; 64 bits wide, so files past 2 GiB work */
+  off_t PageOffset(page_id_t page_id) const {
+    const auto stripe = static_cast<size_t>(page_id) / stripe_pages_;
+    const size_t page_in_file =
+        stripe / data_files_.size() * stripe_pages_ + static_cast<size_t>(page_id) % stripe_pages_;
+    return static_cast<off_t>(page_in_file) * PAGE_SIZE;
+  }
+
+  /** @return how many consecutive page ids from page_id on are also consecutive in its data file */
+  size_t ContiguousPages(page_id_t page_id) const {
+    return data_files_.size() == 1 ? SIZE_MAX : stripe_pages_ - static_cast<size_t>(page_id) % stripe_pages_;
+  }
+
+  /** Record that a data file now extends at least to end. */
+  static void ExtendFileSize(DataFile *file, off_t end);
+
+  /** Make sure a data file has space up to end, preallocating the extents it falls in. */
+  void ReserveSpace(DataFile *file, off_t end);
+
+  /** Sync the data files just written to, as SYNC_ALL asks after every write. */
+  void SyncWritten(const std::vector<DataFile *> &written);
+
+  /** fdatasync a single data file, whatever the durability policy. */
+  static void SyncFile(DataFile *file);
+
+  /**
+   * Read one page at offset, through an aligned copy if direct I/O needs one.
+   * @return the number of bytes read, short at the end of the file, or -1 on error
+   */
+  ssize_t ReadPageAt(DataFile *file, char *page_data, off_t offset);
+
+  /**
+   * Write one page at offset, through an aligned copy if direct I/O needs one.
+   * @return false on error
+   */
+  bool WritePageAt(DataFile *file, const char *page_data, off_t offset);
+
+  /**
+   * Read consecutive pages at offset.
+   * @return the number of bytes read, short at the end of the file, or -1 on error
+   */
+  ssize_t ReadPagesAt(DataFile *file, char *const *pages_data, size_t num_pages, off_t offset);
+
+  /**
+   * Write consecutive pages at offset.
+   * @return false on error
+   */
+  bool WritePagesAt(DataFile *file, const char *const *pages_data, size_t num_pages, off_t offset);
+
+  /**
+   * Run each data file's share of some work on that file's I/O queue, and wait for all of it. With a single data file
+   * the work runs on the calling thread.
+   * @param work the work for each data file, indexed by data file; empty for a file with nothing to do
+   */
+  void RunOnDataFiles(std::vector<std::function<void()>> *work);
+
+  /** Run the tasks queued for a data file until ShutDown. */
+  static void RunIoQueue(DataFile *file);
+
+  /** @return true if direct I/O can transfer a page to or from data as it is */
+  bool CanTransferDirectly(const char *data) const {
+    return !direct_io_ || reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+
+  // descriptor of the log file, and where the next log write goes; only touched by the log flushing thread
+  int log_fd_{-1};
+  off_t log_file_size_{0};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
-  std::string file_name_;
+  std::vector<std::unique_ptr<DataFile>> data_files_;
+  size_t stripe_pages_;
+  // true if the data files were opened with O_DIRECT
+  bool direct_io_{false};
+  DurabilityPolicy durability_policy_{DurabilityPolicy::SYNC_LOG};
+  std::atomic<size_t> extent_size_{DB_FILE_EXTENT_SIZE};
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
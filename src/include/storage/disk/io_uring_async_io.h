@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_async_io.h
+//
+// Identification: src/include/storage/disk/io_uring_async_io.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <memory>
+#include <vector>
+
+#include "storage/disk/async_io.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * IoUringAsyncIo implements AsyncIo on a Linux io_uring, talking to the kernel through the raw system calls rather
+ * than liburing. Submit places a whole batch in the submission queue and enters the kernel once for it; Reap takes
+ * completions off the completion queue and only enters the kernel when it has to wait.
+ *
+ * Pages in a block passed to RegisterBuffers are transferred with the fixed-buffer operations. A transfer the kernel
+ * cuts short, such as a read at the end of the file, is completed with the DiskManager's synchronous interface. So is
+ * a request whose buffer direct I/O cannot use, which the DiskManager copies through an aligned one.
+ */
+class IoUringAsyncIo : public AsyncIo {
+ public:
+  /**
+   * Set up an io_uring.
+   * @param disk_manager the disk manager whose data files are read and written; one ring serves all of them
+   * @param queue_depth the most requests that may be queued and in flight at the same time
+   * @return nullptr if the system has no io_uring, or does not let us use it
+   */
+  static std::unique_ptr<AsyncIo> Create(DiskManager *disk_manager, size_t queue_depth);
+
+  /** Waits for the requests in flight, whose buffers may be about to go away, and tears down the ring. */
+  ~IoUringAsyncIo() override;
+
+  bool RegisterBuffers(char *data, size_t size) override;
+
+  void Submit() override;
+
+  size_t Reap(std::vector<IoCompletion> *completions, size_t min_completions) override;
+
+ private:
+  /** The kernel limits each registered buffer to 1 GiB; larger blocks are registered in pieces of this size. */
+  static constexpr size_t REGISTERED_BUFFER_SIZE = size_t{1} << 30;
+
+  /** A request in flight, indexed by the user_data of its submission. */
+  struct Slot {
+    Request request_;
+    /** The vector of a non-fixed transfer, which has to outlive its submission. */
+    struct iovec iov_;
+  };
+
+  IoUringAsyncIo(DiskManager *disk_manager, int ring_fd, size_t queue_depth);
+
+  /** Map the queues the kernel shares with us. @return false on failure */
+  bool MapRings(const void *params);
+
+  /** Turn a completion queue entry into an IoCompletion, noting the file of a write that Reap has to sync. */
+  void Complete(uint64_t slot, int result, std::vector<IoCompletion> *completions);
+
+  const int ring_fd_;
+  void *sq_ring_;
+  size_t sq_ring_size_{0};
+  void *cq_ring_;
+  size_t cq_ring_size_{0};
+  void *sqes_;
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+  std::vector<Slot> slots_;
+  std::vector<uint64_t> free_slots_;
+  char *registered_data_{nullptr};
+  size_t registered_size_{0};
+  /** Under SYNC_ALL, the data files written by the writes reaped so far, which Reap syncs before it returns. */
+  std::vector<DiskManager::DataFile *> written_files_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_pages.h
+//
+// Identification: src/include/storage/disk/mapped_pages.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class DiskManager;
+
+/**
+ * MappedPages is a read-only memory mapping of the data files, made by DiskManager::MapPages. A cold scan can read the
+ * pages where they lie in the OS page cache instead of copying each one into a buffer pool frame. The mappings are
+ * advised as sequential, so the kernel reads ahead aggressively and lets go of pages soon after they have been used.
+ *
+ * Pages are seen as they are on disk: a page that the buffer pool has not written back yet shows its old contents.
+ * That suits a read-only replica, or a scan after FlushAllPages. A page past the end of its file reads as zeros, as
+ * with ReadPage. A data file that has grown past its mapping is mapped again, with room to spare; the old mapping
+ * stays until the MappedPages is destroyed, so that the pointers GetPage has returned remain valid as long as it
+ * lives. Thread safe.
+ */
+class MappedPages {
+ public:
+  DISALLOW_COPY_AND_MOVE(MappedPages);
+
+  /** Unmaps everything. */
+  ~MappedPages();
+
+  /**
+   * @param page_id id of the page to read
+   * @return the page's data, read-only, valid as long as this MappedPages
+   * @throws Exception if the page's data file cannot be mapped
+   */
+  const char *GetPage(page_id_t page_id);
+
+ private:
+  friend class DiskManager;
+
+  /** One mapping of a data file. */
+  struct Mapping {
+    const char *data_;
+    size_t size_;
+  };
+
+  explicit MappedPages(DiskManager *disk_manager);
+
+  /**
+   * Map a data file anew, if its current mapping does not reach end yet.
+   * @return the current mapping, which reaches end
+   */
+  const Mapping *Remap(size_t data_file, size_t end);
+
+  DiskManager *disk_manager_;
+  // the latest mapping of each data file; nullptr until it is first mapped
+  std::unique_ptr<std::atomic<const Mapping *>[]> current_;
+  // serializes Remap
+  std::mutex latch_;
+  // every mapping made, old ones included
+  std::vector<std::unique_ptr<Mapping>> mappings_;
+};
+
+}  // namespace bustub
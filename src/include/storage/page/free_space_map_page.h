@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * One page of the persistent free page map of a buffer pool instance. The map is a chain of these pages, reachable
+ * from a record in the header page; together they hold one bit per page the instance has allocated, set if the page
+ * has been deallocated since.
+ *
+ * Format (size in byte):
+ *  ------------------------------------------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | NextMapPageId (4) | NextPageId (4) | NumWords (4) | Unused (4) | Word_1 (8) | ... |
+ *  ------------------------------------------------------------------------------------------------------------
+ *
+ * NextPageId is the page id the instance would hand out next once no deallocated page is left; only the copy in the
+ * first page of the chain is used.
+ */
+class FreeSpaceMapPage : public Page {
+ public:
+  /** Number of 64-bit words of the bitmap that fit in one page. */
+  static constexpr size_t MAX_WORDS = (PAGE_SIZE - 24) / sizeof(uint64_t);
+
+  void Init(page_id_t page_id) {
+    memcpy(GetData(), &page_id, sizeof(page_id));
+    SetLSN(INVALID_LSN);
+    SetNextMapPageId(INVALID_PAGE_ID);
+    SetNextPageId(INVALID_PAGE_ID);
+    SetNumWords(0);
+  }
+
+  page_id_t GetNextMapPageId() { return GetField<page_id_t>(OFFSET_NEXT_MAP_PAGE_ID); }
+  void SetNextMapPageId(page_id_t next_map_page_id) { SetField(OFFSET_NEXT_MAP_PAGE_ID, next_map_page_id); }
+
+  page_id_t GetNextPageId() { return GetField<page_id_t>(OFFSET_NEXT_PAGE_ID); }
+  void SetNextPageId(page_id_t next_page_id) { SetField(OFFSET_NEXT_PAGE_ID, next_page_id); }
+
+  uint32_t GetNumWords() { return GetField<uint32_t>(OFFSET_NUM_WORDS); }
+  void SetNumWords(uint32_t num_words) { SetField(OFFSET_NUM_WORDS, num_words); }
+
+  /** @return the bitmap words stored in this page, GetNumWords() of them */
+  uint64_t *GetWords() { return reinterpret_cast<uint64_t *>(GetData() + OFFSET_WORDS); }
+
+ private:
+  static constexpr size_t OFFSET_NEXT_MAP_PAGE_ID = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
+  static constexpr size_t OFFSET_NUM_WORDS = 16;
+  static constexpr size_t OFFSET_WORDS = 24;
+
+  template <typename T>
+  T GetField(size_t offset) {
+    T value;
+    memcpy(&value, GetData() + offset, sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  void SetField(size_t offset, T value) {
+    memcpy(GetData() + offset, &value, sizeof(T));
+  }
+};
+
+}  // namespace bustub
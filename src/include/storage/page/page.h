@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <thread>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,14 +27,29 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data itself lives elsewhere: for a buffer pool frame, in the pool's FrameArena, so that the book-keeping of all
+ * frames is packed into an array of its own, one frame per cache line group, away from the 4 KiB data blocks.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor for a page outside of any buffer pool. Allocates its own data and zeros it out. */
+  Page() : owned_data_(new char[PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
+
+  /** Tag for the constructor of a read-only view. */
+  struct ReadOnlyView {};
+
+  /**
+   * Constructor for a view of page data that someone else owns and that must not be written to, such as a page of
+   * MappedPages. The data is left as it is; only the read accessors may be used, and the latches are not needed.
+   * @param data the page's PAGE_SIZE bytes of data
+   */
+  Page(const char *data, ReadOnlyView /* view */) : data_(const_cast<char *>(data)) {}
+
+  DISALLOW_COPY_AND_MOVE(Page);
 
   /** Default destructor. */
   ~Page() = default;
@@ -49,10 +67,18 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    // An odd version tells optimistic readers that a write is in progress.
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +86,30 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Begin an optimistic read of the page. Instead of taking the read latch, read the page and then pass the returned
+   * version to ROptimisticValidate; anything read in between must be thrown away unless it validates. Waits while the
+   * write latch is held. Only writers that modify the page under WLatch are detected, and the page must stay pinned.
+   * @return the version of the page to validate against
+   */
+  inline uint64_t ROptimisticLatch() const {
+    uint64_t version = version_.load(std::memory_order_acquire);
+    while ((version & 1) != 0) {
+      std::this_thread::yield();
+      version = version_.load(std::memory_order_acquire);
+    }
+    return version;
+  }
+
+  /**
+   * @param version the version returned by ROptimisticLatch
+   * @return true if the page has not been write latched since ROptimisticLatch returned version
+   */
+  inline bool ROptimisticValidate(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -75,11 +125,19 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Constructor for a buffer pool frame. Zeros out the page data.
+   * @param data the frame's PAGE_SIZE bytes of data, owned by the buffer pool
+   */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
+  /** The data of a page that does not belong to a buffer pool. */
+  std::unique_ptr<char[]> owned_data_;
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -88,6 +146,8 @@ class Page {
   bool is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped by WLatch and again by WUnlatch, so it is odd while a writer holds the latch. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
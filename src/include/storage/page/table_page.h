@@ -43,6 +43,8 @@ namespace bustub {
  */
 class TablePage : public Page {
  public:
+  using Page::Page;
+
   /**
    * Initialize the TablePage header.
    * @param page_id the page ID of this table page
@@ -62,6 +64,11 @@ class TablePage : public Page {
   /** @return the page ID of the next table page */
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** @return the page ID of the next table page, given the raw contents of a table page */
+  static page_id_t NextPageIdOf(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
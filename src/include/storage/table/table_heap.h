@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/mapped_pages.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
@@ -46,18 +51,20 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param data_file the data file the table's pages should live in, if the database has several
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, data_file_id_t data_file = ANY_DATA_FILE);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy the ring of a bulk load, if the insert is part of one
    * @return true iff the insert is successful
    */
-  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn);
+  bool InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -99,7 +106,11 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
+  /**
+   * @return the begin iterator of this table. If the table is large compared to the buffer pool, the scan reads it
+   * through a ring of frames (see BufferAccessStrategy) so that it does not flush the rest of the pool. With mapped
+   * pages set, the scan reads them instead, and leaves the buffer pool alone.
+   */
   TableIterator Begin(Transaction *txn);
 
   /** @return the end iterator of this table */
@@ -108,11 +119,47 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return how many pages a sequential scan of this table reads ahead */
+  inline size_t GetReadAheadPages() const { return read_ahead_pages_; }
+
+  /** Set how many pages a sequential scan of this table reads ahead; 0 disables read-ahead. */
+  inline void SetReadAheadPages(size_t read_ahead_pages) { read_ahead_pages_ = read_ahead_pages; }
+
+  /**
+   * Make scans of this table read its pages from a read-only mapping of the data files rather than through the buffer
+   * pool, e.g. on a read-only replica; nullptr to go back to the buffer pool. A page the buffer pool has changes to
+   * that are not on disk yet is read from the buffer pool instead, so pages written through this table heap should be
+   * flushed first for the scan to get the most out of the mapping. Inserts, updates and deletes still go through the
+   * buffer pool. Scans already under way are not affected.
+   * @param mapped_pages the mapping, which must outlive the scans
+   */
+  inline void SetMappedPages(MappedPages *mapped_pages) { mapped_pages_ = mapped_pages; }
+
+  /** @return the number of pages this table heap has created, counting the first page if it created that too */
+  inline size_t GetNumPages() const { return num_pages_; }
+
  private:
+  /** @return true if a scan over this many pages should go through a ring rather than the whole buffer pool */
+  bool IsLargeScan(size_t num_pages) const {
+    return num_pages > buffer_pool_manager_->GetPoolSize() / LARGE_TABLE_POOL_FRACTION;
+  }
+
+  /** @return a ring for a large scan, big enough that read-ahead does not recycle pages the scan has yet to read */
+  std::shared_ptr<BufferAccessStrategy> MakeScanStrategy() const {
+    return std::make_shared<BufferAccessStrategy>(std::max(BUFFER_ACCESS_STRATEGY_RING_SIZE, 2 * read_ahead_pages_));
+  }
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** Where new pages go; an opened table heap does not know where its pages were put, and has no preference. */
+  data_file_id_t data_file_{ANY_DATA_FILE};
+  size_t read_ahead_pages_{READ_AHEAD_PAGES};
+  /** Where scans read the table's pages from, if not through the buffer pool. */
+  MappedPages *mapped_pages_{nullptr};
+  /** A lower bound on the size of the table: an opened table heap does not know how many pages it already had. */
+  std::atomic<size_t> num_pages_{0};
 };
 
 }  // namespace bustub
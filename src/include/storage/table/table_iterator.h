@@ -13,7 +13,11 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/read_ahead_worker.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -23,18 +27,36 @@ namespace bustub {
 class TableHeap;
 
 /**
- * TableIterator enables the sequential scan of a TableHeap.
+ * TableIterator enables the sequential scan of a TableHeap. Once the scan has followed READ_AHEAD_TRIGGER next-page
+ * links in a row, it asks the buffer pool to read the following pages ahead, and keeps that window topped up as it
+ * goes. Read-ahead is not inherited by copies and is cancelled when the scan reaches the end or the iterator dies.
+ *
+ * A scan that turns out to cover much of the buffer pool reads through a ring of frames (see BufferAccessStrategy),
+ * which copies of the iterator share.
+ *
+ * A scan of a table heap with mapped pages (see TableHeap::SetMappedPages) reads the pages in place, without latches,
+ * pins or read-ahead requests of its own; the mapping's sequential advice has the kernel read ahead instead. It reads
+ * a copy of a page from the buffer pool instead when the buffer pool has changes to the page that are not on disk yet.
  */
 class TableIterator {
   friend class Cursor;
+  friend class TableHeap;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
-
-  ~TableIterator() { delete tuple_; }
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        mapped_pages_(other.mapped_pages_) {}
+
+  ~TableIterator() {
+    CancelReadAhead();
+    delete tuple_;
+  }
 
   inline bool operator==(const TableIterator &itr) const { return tuple_->rid_.Get() == itr.tuple_->rid_.Get(); }
 
@@ -49,16 +71,64 @@ class TableIterator {
   TableIterator operator++(int);
 
   TableIterator &operator=(const TableIterator &other) {
+    CancelReadAhead();
+    sequential_pages_ = 0;
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    mapped_pages_ = other.mapped_pages_;
+    mapped_page_id_ = INVALID_PAGE_ID;
     return *this;
   }
 
  private:
+  /**
+   * Note that the scan has moved on to the next page of the table, and read ahead if the scan is sequential.
+   * @param next_page_id the next-page link of the page just entered
+   */
+  void EnterNextPage(page_id_t next_page_id);
+
+  /** Cancel the outstanding read-ahead request, if any. */
+  void CancelReadAhead();
+
+  /** operator++ for a scan of mapped pages. */
+  void NextMappedTuple();
+
+  /** Read the tuple at tuple_'s rid from the mapped pages. */
+  void ReadMappedTuple();
+
+  /**
+   * @param page_id the page to start at
+   * @return the rid of the first tuple on this mapped page or the ones after it; an invalid rid if there is none
+   * @throws Exception if a page is neither on disk nor changed in the buffer pool
+   */
+  RID FirstMappedTupleRid(page_id_t page_id);
+
+  /**
+   * @param page_id id of the page to read
+   * @return the page's data in the mapping, or a copy of it from the buffer pool if that has changes to it that are not
+   * on disk yet; valid until a different page is read
+   */
+  const char *MappedPage(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The ring this scan reads through, or nullptr to use the whole buffer pool. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** The mapping this scan reads, or nullptr to read through the buffer pool. */
+  MappedPages *mapped_pages_;
+  /** The page MappedPage read last, and its data. */
+  page_id_t mapped_page_id_{INVALID_PAGE_ID};
+  const char *mapped_page_{nullptr};
+  /** Where MappedPage copies a page from the buffer pool to; allocated on first use. */
+  std::unique_ptr<char[]> page_copy_;
+  /** Number of pages entered in a row by following next-page links. */
+  size_t sequential_pages_{0};
+  /** Number of pages entered since read_ahead_ was issued. */
+  size_t pages_since_read_ahead_{0};
+  std::shared_ptr<ReadAheadRequest> read_ahead_;
 };
 
 }  // namespace bustub
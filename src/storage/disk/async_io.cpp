@@ -0,0 +1,40 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io.cpp
+//
+// Identification: src/storage/disk/async_io.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_io.h"
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+void AsyncIo::Submit() {
+  for (const Request &request : queued_) {
+    if (request.is_write_) {
+      disk_manager_->WritePage(request.page_id_, request.page_data_);
+    } else {
+      disk_manager_->ReadPage(request.page_id_, request.page_data_);
+    }
+    completed_.push_back(IoCompletion{request.tag_, true});
+  }
+  num_in_flight_ += queued_.size();
+  queued_.clear();
+}
+
+size_t AsyncIo::Reap(std::vector<IoCompletion> *completions, size_t min_completions) {
+  const size_t num_reaped = completed_.size();
+  completions->insert(completions->end(), completed_.begin(), completed_.end());
+  completed_.clear();
+  num_in_flight_ -= num_reaped;
+  return num_reaped;
+}
+
+}  // namespace bustub
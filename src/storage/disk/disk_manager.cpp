@@ -10,128 +10,565 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <functional>
+#include <future>  // NOLINT
 #include <iostream>
-#include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/io_uring_async_io.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** Aligned stand-in for a caller's buffer that direct I/O cannot use; one per thread, as I/O runs in parallel. */
+alignas(DIRECT_IO_ALIGNMENT) static thread_local char aligned_page[PAGE_SIZE];
+
+/**
+ * preadv until every buffer is full or the file ends, retrying interrupted and short reads
+ * @return the number of bytes read, or -1 on error
+ */
+static ssize_t ReadVectorFully(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+  size_t done = 0;
+  while (iovcnt > 0) {
+    ssize_t n = preadv(fd, iov, iovcnt, offset + static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -1;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+    // Skip what was transferred, which may end in the middle of a buffer.
+    while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return done;
+}
+
+/**
+ * pwritev every buffer, retrying interrupted and short writes
+ * @return false on error
+ */
+static bool WriteVectorFully(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+  size_t done = 0;
+  while (iovcnt > 0) {
+    ssize_t n = pwritev(fd, iov, iovcnt, offset + static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+    while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+/** ReadVectorFully into a single buffer */
+static ssize_t ReadFully(int fd, char *data, size_t size, off_t offset) {
+  struct iovec iov = {data, size};
+  return ReadVectorFully(fd, &iov, 1, offset);
+}
+
+/** WriteVectorFully from a single buffer */
+static bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  struct iovec iov = {const_cast<char *>(data), size};
+  return WriteVectorFully(fd, &iov, 1, offset);
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
-  std::string::size_type n = file_name_.rfind('.');
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : DiskManager(std::vector<std::string>{db_file}, DATA_FILE_STRIPE_PAGES, direct_io) {}
+
+/**
+ * Constructor: open/create the data files of a tablespace & the log file
+ * @input db_files: data file names, the first of which names the log file
+ */
+DiskManager::DiskManager(const std::vector<std::string> &db_files, size_t stripe_pages, bool direct_io)
+    : stripe_pages_(stripe_pages), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+  BUSTUB_ASSERT(!db_files.empty() && stripe_pages > 0, "a tablespace needs at least one file and stripe page");
+  for (size_t i = 0; i < db_files.size(); i++) {
+    data_files_.push_back(std::make_unique<DataFile>());
+  }
+  std::string::size_type n = db_files[0].rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
-
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
-
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+  log_name_ = db_files[0].substr(0, n) + ".log";
+
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  struct stat stat_buf;
+  if (log_fd_ < 0 || fstat(log_fd_, &stat_buf) != 0) {
+    throw Exception("can't open dblog file");
+  }
+  log_file_size_ = stat_buf.st_size;
+
+  const int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+  for (size_t i = 0; i < db_files.size(); i++) {
+    DataFile *file = data_files_[i].get();
+#ifdef O_DIRECT
+    if (direct_io) {
+      file->fd_ = open(db_files[i].c_str(), flags | O_DIRECT, 0644);
+      if (file->fd_ >= 0) {
+        direct_io_ = true;
+      } else {
+        // EINVAL from e.g. tmpfs, which has no direct I/O
+        LOG_DEBUG("O_DIRECT refused for %s (%s), using buffered I/O", db_files[i].c_str(), strerror(errno));
+      }
+    }
+#endif
+    if (file->fd_ < 0) {
+      file->fd_ = open(db_files[i].c_str(), flags, 0644);
+    }
+    if (file->fd_ < 0 || fstat(file->fd_, &stat_buf) != 0) {
+      ShutDown();
       throw Exception("can't open db file");
     }
+    file->size_ = stat_buf.st_size;
+    file->allocated_size_ = stat_buf.st_size;
+  }
+  if (data_files_.size() > 1) {
+    for (auto &file : data_files_) {
+      file->io_thread_running_ = true;
+      file->io_thread_ = std::thread(RunIoQueue, file.get());
+    }
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() { ShutDown(); }
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  for (auto &file : data_files_) {
+    if (file->io_thread_.joinable()) {
+      {
+        std::scoped_lock lock(file->io_queue_latch_);
+        file->io_thread_running_ = false;
+      }
+      file->io_queue_cv_.notify_one();
+      file->io_thread_.join();
+    }
+    if (file->fd_ >= 0) {
+      close(file->fd_);
+      file->fd_ = -1;
+    }
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
+}
+
+/**
+ * Raise the cached size of a data file to cover a write that ended at end
+ */
+void DiskManager::ExtendFileSize(DataFile *file, off_t end) {
+  off_t size = file->size_.load(std::memory_order_relaxed);
+  while (size < end && !file->size_.compare_exchange_weak(size, end, std::memory_order_relaxed)) {
+  }
+}
+
+/**
+ * Preallocate the extents of a data file up to end, unless they are already
+ * A write far past the allocated space leaves a hole rather than preallocating everything before it. The file's size
+ * stays at the last page written, so a restart after a crash does not take the preallocated space for pages.
+ */
+void DiskManager::ReserveSpace(DataFile *file, off_t end) {
+  if (extent_size_ == 0 || end <= file->allocated_size_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::scoped_lock lock(file->allocation_latch_);
+  const off_t allocated = file->allocated_size_.load(std::memory_order_relaxed);
+  const auto extent_size = static_cast<off_t>(extent_size_.load());
+  if (extent_size == 0 || end <= allocated) {
+    return;
   }
-  log_io_.close();
+  const off_t start = std::max(allocated, (end - 1) / extent_size * extent_size);
+  const off_t new_allocated = (end + extent_size - 1) / extent_size * extent_size;
+#ifdef __linux__
+  if (fallocate(file->fd_, FALLOC_FL_KEEP_SIZE, start, new_allocated - start) == 0) {
+    file->allocated_size_.store(new_allocated, std::memory_order_release);
+    return;
+  }
+  LOG_DEBUG("cannot preallocate the db file (%s), growing it a page at a time", strerror(errno));
+#endif
+  extent_size_ = 0;
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  DataFile *file = FileOf(page_id);
+  off_t offset = PageOffset(page_id);
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  ReserveSpace(file, offset + PAGE_SIZE);
+  // pwrite hands the page straight to the OS, so there is nothing left to flush
+  if (!WritePageAt(file, page_data, offset)) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  ExtendFileSize(file, offset + PAGE_SIZE);
+  if (durability_policy_ == DurabilityPolicy::SYNC_ALL) {
+    SyncWritten({file});
+  }
+}
+
+/**
+ * Write the contents of consecutive pages into disk file, without flushing
+ * Each stretch of up to IOV_MAX pages that is consecutive in its data file goes out with one pwritev
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) {
+  num_writes_ += static_cast<int>(num_pages);
+  std::vector<DataFile *> written;
+  for (size_t begin = 0; begin < num_pages;) {
+    const page_id_t page_id = first_page_id + static_cast<page_id_t>(begin);
+    const size_t count = std::min({num_pages - begin, ContiguousPages(page_id), static_cast<size_t>(IOV_MAX)});
+    DataFile *file = FileOf(page_id);
+    const off_t offset = PageOffset(page_id);
+    ReserveSpace(file, offset + static_cast<off_t>(count * PAGE_SIZE));
+    if (!WritePagesAt(file, pages_data + begin, count, offset)) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    ExtendFileSize(file, offset + static_cast<off_t>(count * PAGE_SIZE));
+    if (std::find(written.begin(), written.end(), file) == written.end()) {
+      written.push_back(file);
+    }
+    begin += count;
+  }
+  if (durability_policy_ == DurabilityPolicy::SYNC_ALL) {
+    SyncWritten(written);
+  }
+}
+
+/**
+ * Write a batch of pages, one run of consecutive page ids at a time, and Sync once at the end if asked to
+ * Each data file writes its runs on its own I/O queue
+ */
+void DiskManager::WritePageBatch(const std::pair<page_id_t, const char *> *pages, size_t num_pages, bool sync) {
+  std::vector<std::vector<std::pair<page_id_t, std::vector<const char *>>>> runs(data_files_.size());
+  for (size_t begin = 0; begin < num_pages;) {
+    // A run ends where the batch skips a page id or the stripe ends.
+    const size_t max_length = ContiguousPages(pages[begin].first);
+    std::vector<const char *> run_data{pages[begin].second};
+    size_t end = begin + 1;
+    while (end < num_pages && end - begin < max_length && pages[end].first == pages[end - 1].first + 1) {
+      run_data.push_back(pages[end++].second);
+    }
+    runs[GetDataFile(pages[begin].first)].emplace_back(pages[begin].first, std::move(run_data));
+    begin = end;
+  }
+  std::vector<std::function<void()>> work(data_files_.size());
+  for (size_t i = 0; i < data_files_.size(); i++) {
+    if (!runs[i].empty()) {
+      work[i] = [this, &file_runs = runs[i]] {
+        for (const auto &[first_page_id, run_data] : file_runs) {
+          WritePages(first_page_id, run_data.data(), run_data.size());
+        }
+      };
+    }
+  }
+  RunOnDataFiles(&work);
+  if (sync && num_pages > 0) {
+    Sync();
+  }
+}
+
+/**
+ * Make every page written so far durable, unless the policy says never to
+ * The data files are synced in parallel, each on its own I/O queue
+ */
+void DiskManager::Sync() {
+  if (durability_policy_ == DurabilityPolicy::NO_SYNC) {
+    return;
+  }
+  std::vector<std::function<void()>> work(data_files_.size());
+  for (size_t i = 0; i < data_files_.size(); i++) {
+    work[i] = [file = data_files_[i].get()] { SyncFile(file); };
+  }
+  RunOnDataFiles(&work);
+}
+
+/**
+ * Sync after a write under SYNC_ALL. With several data files, only the ones written to are synced, and directly: the
+ * write may be running on an I/O queue, which Sync would wait on.
+ */
+void DiskManager::SyncWritten(const std::vector<DataFile *> &written) {
+  if (data_files_.size() == 1) {
+    Sync();
+    return;
+  }
+  for (DataFile *file : written) {
+    SyncFile(file);
+  }
+}
+
+/**
+ * fdatasync one data file
+ */
+void DiskManager::SyncFile(DataFile *file) {
+  if (fdatasync(file->fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
+  DataFile *file = FileOf(page_id);
+  off_t offset = PageOffset(page_id);
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset >= file->size_.load(std::memory_order_relaxed)) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  ssize_t read_count = ReadPageAt(file, page_data, offset);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Read the contents of consecutive pages into the given memory areas
+ * Each stretch of up to IOV_MAX pages that is consecutive in its data file comes in with one preadv
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, char *const *pages_data, size_t num_pages) {
+  for (size_t begin = 0; begin < num_pages;) {
+    const page_id_t page_id = first_page_id + static_cast<page_id_t>(begin);
+    const size_t count = std::min({num_pages - begin, ContiguousPages(page_id), static_cast<size_t>(IOV_MAX)});
+    DataFile *file = FileOf(page_id);
+    const off_t offset = PageOffset(page_id);
+    ssize_t read_count =
+        offset < file->size_.load(std::memory_order_relaxed) ? ReadPagesAt(file, pages_data + begin, count, offset) : 0;
+    if (read_count < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    // Whatever lies past the end of the file reads as zeros.
+    const auto pages_read = static_cast<size_t>(read_count) / PAGE_SIZE;
+    for (size_t i = pages_read; i < count; i++) {
+      const size_t valid = i == pages_read ? static_cast<size_t>(read_count) % PAGE_SIZE : 0;
+      memset(pages_data[begin + i] + valid, 0, PAGE_SIZE - valid);
     }
+    begin += count;
   }
 }
 
+/**
+ * Read a batch of pages, one run of consecutive page ids at a time
+ * Each data file reads its runs on its own I/O queue
+ */
+void DiskManager::ReadPageBatch(const std::pair<page_id_t, char *> *pages, size_t num_pages) {
+  std::vector<std::vector<std::pair<page_id_t, std::vector<char *>>>> runs(data_files_.size());
+  for (size_t begin = 0; begin < num_pages;) {
+    const size_t max_length = ContiguousPages(pages[begin].first);
+    std::vector<char *> run_data{pages[begin].second};
+    size_t end = begin + 1;
+    while (end < num_pages && end - begin < max_length && pages[end].first == pages[end - 1].first + 1) {
+      run_data.push_back(pages[end++].second);
+    }
+    runs[GetDataFile(pages[begin].first)].emplace_back(pages[begin].first, std::move(run_data));
+    begin = end;
+  }
+  std::vector<std::function<void()>> work(data_files_.size());
+  for (size_t i = 0; i < data_files_.size(); i++) {
+    if (!runs[i].empty()) {
+      work[i] = [this, &file_runs = runs[i]] {
+        for (const auto &[first_page_id, run_data] : file_runs) {
+          ReadPages(first_page_id, run_data.data(), run_data.size());
+        }
+      };
+    }
+  }
+  RunOnDataFiles(&work);
+}
+
+/**
+ * Read a page at the given offset, bouncing it through an aligned buffer if direct I/O cannot use the caller's
+ */
+ssize_t DiskManager::ReadPageAt(DataFile *file, char *page_data, off_t offset) {
+  if (CanTransferDirectly(page_data)) {
+    return ReadFully(file->fd_, page_data, PAGE_SIZE, offset);
+  }
+  ssize_t read_count = ReadFully(file->fd_, aligned_page, PAGE_SIZE, offset);
+  if (read_count > 0) {
+    memcpy(page_data, aligned_page, read_count);
+  }
+  return read_count;
+}
+
+/**
+ * Write a page at the given offset, bouncing it through an aligned buffer if direct I/O cannot use the caller's
+ */
+bool DiskManager::WritePageAt(DataFile *file, const char *page_data, off_t offset) {
+  if (CanTransferDirectly(page_data)) {
+    return WriteFully(file->fd_, page_data, PAGE_SIZE, offset);
+  }
+  memcpy(aligned_page, page_data, PAGE_SIZE);
+  return WriteFully(file->fd_, aligned_page, PAGE_SIZE, offset);
+}
+
+/**
+ * Read consecutive pages at the given offset with one preadv, or page by page if direct I/O cannot use every buffer
+ */
+ssize_t DiskManager::ReadPagesAt(DataFile *file, char *const *pages_data, size_t num_pages, off_t offset) {
+  std::vector<struct iovec> iovecs(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    if (!CanTransferDirectly(pages_data[i])) {
+      size_t done = 0;
+      for (size_t j = 0; j < num_pages; j++) {
+        ssize_t read_count = ReadPageAt(file, pages_data[j], offset + static_cast<off_t>(done));
+        if (read_count < 0) {
+          return -1;
+        }
+        done += read_count;
+        if (read_count < PAGE_SIZE) {
+          break;
+        }
+      }
+      return done;
+    }
+    iovecs[i] = {pages_data[i], PAGE_SIZE};
+  }
+  return ReadVectorFully(file->fd_, iovecs.data(), static_cast<int>(num_pages), offset);
+}
+
+/**
+ * Write consecutive pages at the given offset with one pwritev, or page by page if direct I/O cannot use every buffer
+ */
+bool DiskManager::WritePagesAt(DataFile *file, const char *const *pages_data, size_t num_pages, off_t offset) {
+  std::vector<struct iovec> iovecs(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    if (!CanTransferDirectly(pages_data[i])) {
+      for (size_t j = 0; j < num_pages; j++) {
+        if (!WritePageAt(file, pages_data[j], offset + static_cast<off_t>(j * PAGE_SIZE))) {
+          return false;
+        }
+      }
+      return true;
+    }
+    iovecs[i] = {const_cast<char *>(pages_data[i]), PAGE_SIZE};
+  }
+  return WriteVectorFully(file->fd_, iovecs.data(), static_cast<int>(num_pages), offset);
+}
+
+/**
+ * Hand each data file its work and wait for all of it
+ */
+void DiskManager::RunOnDataFiles(std::vector<std::function<void()>> *work) {
+  std::vector<std::future<void>> done;
+  for (size_t i = 0; i < data_files_.size(); i++) {
+    if (!(*work)[i]) {
+      continue;
+    }
+    if (data_files_.size() == 1) {
+      (*work)[i]();
+      continue;
+    }
+    DataFile *file = data_files_[i].get();
+    std::packaged_task<void()> task(std::move((*work)[i]));
+    done.push_back(task.get_future());
+    {
+      std::scoped_lock lock(file->io_queue_latch_);
+      file->io_queue_.push_back(std::move(task));
+    }
+    file->io_queue_cv_.notify_one();
+  }
+  for (auto &result : done) {
+    result.get();
+  }
+}
+
+/**
+ * The I/O thread of a data file: run what is queued for it, in order, until shut down
+ */
+void DiskManager::RunIoQueue(DataFile *file) {
+  std::unique_lock lock(file->io_queue_latch_);
+  while (true) {
+    file->io_queue_cv_.wait(lock, [file] { return !file->io_queue_.empty() || !file->io_thread_running_; });
+    if (file->io_queue_.empty()) {
+      return;
+    }
+    std::packaged_task<void()> task = std::move(file->io_queue_.front());
+    file->io_queue_.pop_front();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
+
+/**
+ * Create an io_uring backed AsyncIo, or the synchronous fallback where io_uring is unavailable
+ */
+std::unique_ptr<AsyncIo> DiskManager::CreateAsyncIo(size_t queue_depth) {
+  std::unique_ptr<AsyncIo> io = IoUringAsyncIo::Create(this, queue_depth);
+  if (io == nullptr) {
+    io = std::make_unique<AsyncIo>(this, queue_depth);
+  }
+  return io;
+}
+
+/**
+ * Map the data files read-only; each is mapped when a page of it is first read
+ */
+std::unique_ptr<MappedPages> DiskManager::MapPages() { return std::unique_ptr<MappedPages>(new MappedPages(this)); }
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
+ * One call writes and syncs a whole log buffer, so every commit in it shares the sync
  */
 void DiskManager::WriteLog(char *log_data, int size) {
   // enforce swap log buffer
@@ -151,15 +588,16 @@ void DiskManager::WriteLog(char *log_data, int size) {
 
   num_flushes_ += 1;
   // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
+  if (!WriteFully(log_fd_, log_data, size, log_file_size_)) {
     LOG_DEBUG("I/O error while writing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  log_file_size_ += size;
+  // the log records must be durable before any page they describe is written
+  if (durability_policy_ != DurabilityPolicy::NO_SYNC && fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
+    return;
+  }
   flush_log_ = false;
 }
 
@@ -169,22 +607,16 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * @return: false means already reach the end
  */
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
-    // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+  if (offset >= log_file_size_) {
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  ssize_t read_count = ReadFully(log_fd_, log_data, size, offset);
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
@@ -201,18 +633,24 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 int DiskManager::GetNumWrites() const { return num_writes_; }
 
+page_id_t DiskManager::GetNumPages() const {
+  page_id_t num_pages = 0;
+  for (size_t i = 0; i < data_files_.size(); i++) {
+    const auto pages_in_file = static_cast<size_t>(data_files_[i]->size_.load(std::memory_order_relaxed) / PAGE_SIZE);
+    if (pages_in_file == 0) {
+      continue;
+    }
+    // Map the file's last page back to its page id, the inverse of PageOffset.
+    const size_t last = pages_in_file - 1;
+    const size_t stripe = last / stripe_pages_ * data_files_.size() + i;
+    num_pages = std::max(num_pages, static_cast<page_id_t>(stripe * stripe_pages_ + last % stripe_pages_ + 1));
+  }
+  return num_pages;
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
-/**
- * Private helper function to get disk file size
- */
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
-}
-
 }  // namespace bustub
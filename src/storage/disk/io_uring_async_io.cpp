@@ -0,0 +1,285 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_async_io.cpp
+//
+// Identification: src/storage/disk/io_uring_async_io.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring_async_io.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/disk_manager.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define BUSTUB_HAVE_IO_URING
+#endif
+#endif
+
+namespace bustub {
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+namespace {
+
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, const void *arg, unsigned num_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, num_args));
+}
+
+}  // namespace
+
+std::unique_ptr<AsyncIo> IoUringAsyncIo::Create(DiskManager *disk_manager, size_t queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = IoUringSetup(static_cast<unsigned>(queue_depth), &params);
+  if (ring_fd < 0) {
+    // ENOSYS without the system call, EPERM where a sandbox or io_uring_disabled forbids it.
+    return nullptr;
+  }
+  std::unique_ptr<IoUringAsyncIo> io(new IoUringAsyncIo(disk_manager, ring_fd, queue_depth));
+  if (!io->MapRings(&params)) {
+    return nullptr;
+  }
+  return io;
+}
+
+IoUringAsyncIo::IoUringAsyncIo(DiskManager *disk_manager, int ring_fd, size_t queue_depth)
+    : AsyncIo(disk_manager, queue_depth),
+      ring_fd_(ring_fd),
+      sq_ring_(MAP_FAILED),
+      cq_ring_(MAP_FAILED),
+      sqes_(MAP_FAILED),
+      slots_(queue_depth) {
+  for (size_t i = queue_depth; i > 0; i--) {
+    free_slots_.push_back(i - 1);
+  }
+}
+
+bool IoUringAsyncIo::MapRings(const void *params_ptr) {
+  const auto &params = *static_cast<const io_uring_params *>(params_ptr);
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    return false;
+  }
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                IORING_OFF_CQ_RING);
+  if (cq_ring_ == MAP_FAILED) {
+    return false;
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    return false;
+  }
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return true;
+}
+
+IoUringAsyncIo::~IoUringAsyncIo() {
+  if (cqes_ != nullptr) {
+    Submit();
+    std::vector<IoCompletion> completions;
+    Reap(&completions, num_in_flight_);
+  }
+  if (sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  close(ring_fd_);
+}
+
+bool IoUringAsyncIo::RegisterBuffers(char *data, size_t size) {
+  BUSTUB_ASSERT(GetNumPending() == 0, "buffers must be registered before any request is queued");
+  std::vector<struct iovec> iovecs;
+  for (size_t offset = 0; offset < size; offset += REGISTERED_BUFFER_SIZE) {
+    iovecs.push_back({data + offset, std::min(REGISTERED_BUFFER_SIZE, size - offset)});
+  }
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(iovecs.size())) != 0) {
+    // Typically ENOMEM: the block is more than RLIMIT_MEMLOCK allows us to pin.
+    LOG_DEBUG("cannot register buffers with io_uring: %s", strerror(errno));
+    return false;
+  }
+  registered_data_ = data;
+  registered_size_ = size;
+  return true;
+}
+
+void IoUringAsyncIo::Submit() {
+  if (queued_.empty()) {
+    return;
+  }
+  auto *sqes = static_cast<io_uring_sqe *>(sqes_);
+  unsigned tail = *sq_tail_;
+  unsigned to_submit = 0;
+  for (const Request &request : queued_) {
+    if (!disk_manager_->CanTransferDirectly(request.page_data_)) {
+      // Direct I/O would fail on this buffer; the synchronous interface copies it to an aligned one.
+      if (request.is_write_) {
+        disk_manager_->WritePage(request.page_id_, request.page_data_);
+      } else {
+        disk_manager_->ReadPage(request.page_id_, request.page_data_);
+      }
+      completed_.push_back(IoCompletion{request.tag_, true});
+      continue;
+    }
+    DiskManager::DataFile *file = disk_manager_->FileOf(request.page_id_);
+    const off_t file_offset = disk_manager_->PageOffset(request.page_id_);
+    if (request.is_write_) {
+      disk_manager_->ReserveSpace(file, file_offset + PAGE_SIZE);
+    }
+    const uint64_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[slot].request_ = request;
+
+    const unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = file->fd_;
+    sqe->off = static_cast<uint64_t>(file_offset);
+    sqe->user_data = slot;
+    const auto offset = static_cast<size_t>(request.page_data_ - registered_data_);
+    if (request.page_data_ >= registered_data_ && offset + PAGE_SIZE <= registered_size_) {
+      sqe->opcode = request.is_write_ ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+      sqe->addr = reinterpret_cast<uint64_t>(request.page_data_);
+      sqe->len = PAGE_SIZE;
+      sqe->buf_index = static_cast<uint16_t>(offset / REGISTERED_BUFFER_SIZE);
+    } else {
+      slots_[slot].iov_ = {request.page_data_, PAGE_SIZE};
+      sqe->opcode = request.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->addr = reinterpret_cast<uint64_t>(&slots_[slot].iov_);
+      sqe->len = 1;
+    }
+    sq_array_[index] = index;
+    tail++;
+    to_submit++;
+  }
+  // Publish the entries before the kernel can see the new tail.
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+  num_in_flight_ += queued_.size();
+  queued_.clear();
+  while (to_submit > 0) {
+    const int submitted = IoUringEnter(ring_fd_, to_submit, 0, 0);
+    if (submitted >= 0) {
+      to_submit -= static_cast<unsigned>(submitted);
+    } else if (errno == EAGAIN || errno == EBUSY) {
+      // Out of resources for now; wait for something to complete, which the next Reap collects.
+      IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    } else if (errno != EINTR) {
+      throw Exception("io_uring_enter failed while submitting");
+    }
+  }
+}
+
+size_t IoUringAsyncIo::Reap(std::vector<IoCompletion> *completions, size_t min_completions) {
+  min_completions = std::min(min_completions, num_in_flight_);
+  const auto *cqes = static_cast<const io_uring_cqe *>(cqes_);
+  size_t num_reaped = completed_.size();
+  completions->insert(completions->end(), completed_.begin(), completed_.end());
+  completed_.clear();
+  num_in_flight_ -= num_reaped;
+  while (true) {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++, num_reaped++) {
+      const io_uring_cqe &cqe = cqes[head & *cq_mask_];
+      Complete(cqe.user_data, cqe.res, completions);
+    }
+    // Hand the entries back to the kernel only once we are done reading them.
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (num_reaped >= min_completions) {
+      if (!written_files_.empty()) {
+        // Under SYNC_ALL, a write is not complete until it is synced, as with WritePage.
+        disk_manager_->SyncWritten(written_files_);
+        written_files_.clear();
+      }
+      return num_reaped;
+    }
+    if (IoUringEnter(ring_fd_, 0, static_cast<unsigned>(min_completions - num_reaped), IORING_ENTER_GETEVENTS) < 0 &&
+        errno != EINTR) {
+      throw Exception("io_uring_enter failed while waiting");
+    }
+  }
+}
+
+void IoUringAsyncIo::Complete(uint64_t slot, int result, std::vector<IoCompletion> *completions) {
+  const Request request = slots_[slot].request_;
+  free_slots_.push_back(slot);
+  num_in_flight_--;
+  bool ok = result == PAGE_SIZE;
+  if (result >= 0 && result < PAGE_SIZE) {
+    // Cut short, by the end of the file or otherwise; the synchronous interface knows how to deal with either.
+    if (request.is_write_) {
+      disk_manager_->WritePage(request.page_id_, request.page_data_);
+    } else {
+      disk_manager_->ReadPage(request.page_id_, request.page_data_);
+    }
+    ok = true;
+  } else if (result < 0) {
+    LOG_DEBUG("I/O error in io_uring request: %s", strerror(-result));
+  } else if (request.is_write_) {
+    disk_manager_->num_writes_ += 1;
+    DiskManager::DataFile *file = disk_manager_->FileOf(request.page_id_);
+    DiskManager::ExtendFileSize(file, disk_manager_->PageOffset(request.page_id_) + PAGE_SIZE);
+    if (disk_manager_->GetDurabilityPolicy() == DurabilityPolicy::SYNC_ALL &&
+        std::find(written_files_.begin(), written_files_.end(), file) == written_files_.end()) {
+      written_files_.push_back(file);
+    }
+  }
+  completions->push_back(IoCompletion{request.tag_, ok});
+}
+
+#else
+
+std::unique_ptr<AsyncIo> IoUringAsyncIo::Create(DiskManager *disk_manager, size_t queue_depth) {
+  return nullptr;
+}
+
+#endif
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_pages.cpp
+//
+// Identification: src/storage/disk/mapped_pages.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/mapped_pages.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/** What a page past the end of its file reads as. */
+alignas(DIRECT_IO_ALIGNMENT) static const char zero_page[PAGE_SIZE] = {};
+
+MappedPages::MappedPages(DiskManager *disk_manager)
+    : disk_manager_(disk_manager),
+      current_(new std::atomic<const Mapping *>[disk_manager->GetNumDataFiles()]) {
+  for (size_t i = 0; i < disk_manager_->GetNumDataFiles(); i++) {
+    current_[i] = nullptr;
+  }
+}
+
+MappedPages::~MappedPages() {
+  for (const auto &mapping : mappings_) {
+    munmap(const_cast<char *>(mapping->data_), mapping->size_);
+  }
+}
+
+const char *MappedPages::GetPage(page_id_t page_id) {
+  const data_file_id_t data_file = disk_manager_->GetDataFile(page_id);
+  const off_t offset = disk_manager_->PageOffset(page_id);
+  const auto end = static_cast<size_t>(offset) + PAGE_SIZE;
+  // Never written, and maybe past the end of the file, where the mapping would fault.
+  if (static_cast<off_t>(end) > disk_manager_->data_files_[data_file]->size_.load(std::memory_order_relaxed)) {
+    return zero_page;
+  }
+  const Mapping *mapping = current_[data_file].load(std::memory_order_acquire);
+  if (mapping == nullptr || end > mapping->size_) {
+    mapping = Remap(data_file, end);
+  }
+  return mapping->data_ + offset;
+}
+
+const MappedPages::Mapping *MappedPages::Remap(size_t data_file, size_t end) {
+  std::scoped_lock lock(latch_);
+  const Mapping *current = current_[data_file].load(std::memory_order_relaxed);
+  if (current != nullptr && end <= current->size_) {
+    return current;
+  }
+  // Leave room for the file to double before it has to be mapped again. Mapping past the end of the file is fine as
+  // long as nothing there is touched before the file gets that far.
+  const size_t size = std::max(2 * end, DB_FILE_EXTENT_SIZE) / PAGE_SIZE * PAGE_SIZE;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, disk_manager_->data_files_[data_file]->fd_, 0);
+  if (data == MAP_FAILED) {
+    LOG_DEBUG("cannot map the db file: %s", strerror(errno));
+    throw Exception("can't map db file");
+  }
+  if (madvise(data, size, MADV_SEQUENTIAL) != 0) {
+    LOG_DEBUG("madvise(MADV_SEQUENTIAL) failed: %s", strerror(errno));
+  }
+  mappings_.push_back(std::make_unique<Mapping>(Mapping{static_cast<const char *>(data), size}));
+  current_[data_file].store(mappings_.back().get(), std::memory_order_release);
+  return mappings_.back().get();
+}
+
+}  // namespace bustub
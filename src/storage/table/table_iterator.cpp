@@ -11,14 +11,27 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <cstring>
 
+#include "common/exception.h"
+#include "common/logger.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
-  if (rid.GetPageId() != INVALID_PAGE_ID) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(rid)),
+      txn_(txn),
+      strategy_(std::move(strategy)),
+      mapped_pages_(table_heap != nullptr ? table_heap->mapped_pages_ : nullptr) {
+  if (rid.GetPageId() == INVALID_PAGE_ID) {
+    return;
+  }
+  if (mapped_pages_ != nullptr) {
+    ReadMappedTuple();
+  } else {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
 }
@@ -34,8 +47,13 @@ Tuple *TableIterator::operator->() {
 }
 
 TableIterator &TableIterator::operator++() {
+  if (mapped_pages_ != nullptr) {
+    NextMappedTuple();
+    return *this;
+  }
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page =
+      static_cast<TablePage *>(buffer_pool_manager->FetchPageWithStrategy(tuple_->rid_.GetPageId(), strategy_.get()));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
@@ -43,11 +61,13 @@ TableIterator &TableIterator::operator++() {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page = static_cast<TablePage *>(
+          buffer_pool_manager->FetchPageWithStrategy(cur_page->GetNextPageId(), strategy_.get()));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      EnterNextPage(cur_page->GetNextPageId());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -57,6 +77,8 @@ TableIterator &TableIterator::operator++() {
 
   if (*this != table_heap_->End()) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+  } else {
+    CancelReadAhead();
   }
   // release until copy the tuple
   cur_page->RUnlatch();
@@ -64,6 +86,91 @@ TableIterator &TableIterator::operator++() {
   return *this;
 }
 
+void TableIterator::EnterNextPage(page_id_t next_page_id) {
+  sequential_pages_++;
+  if (strategy_ == nullptr && table_heap_->IsLargeScan(sequential_pages_ + 1)) {
+    // The table heap did not know the table was this large; stop the rest of the scan from flushing the pool.
+    strategy_ = table_heap_->MakeScanStrategy();
+  }
+  size_t read_ahead_pages = table_heap_->GetReadAheadPages();
+  if (read_ahead_pages == 0 || sequential_pages_ < READ_AHEAD_TRIGGER || next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  // Issue a new window once the scan has consumed half of the previous one, so that the pages it needs next are
+  // always being read while it works on the current one. The pages of the new window that are already resident cost
+  // the worker nothing.
+  if (read_ahead_ != nullptr && ++pages_since_read_ahead_ < (read_ahead_pages + 1) / 2) {
+    return;
+  }
+  CancelReadAhead();
+  read_ahead_ =
+      table_heap_->buffer_pool_manager_->ReadAhead(next_page_id, read_ahead_pages, &TablePage::NextPageIdOf, strategy_);
+  pages_since_read_ahead_ = 0;
+}
+
+void TableIterator::NextMappedTuple() {
+  RID next_tuple_rid;
+  TablePage page(MappedPage(tuple_->rid_.GetPageId()), Page::ReadOnlyView{});
+  if (!page.GetNextTupleRid(tuple_->rid_, &next_tuple_rid)) {
+    next_tuple_rid = FirstMappedTupleRid(page.GetNextPageId());
+  }
+  tuple_->rid_ = next_tuple_rid;
+  if (*this != table_heap_->End()) {
+    ReadMappedTuple();
+  }
+}
+
+void TableIterator::ReadMappedTuple() {
+  TablePage page(MappedPage(tuple_->rid_.GetPageId()), Page::ReadOnlyView{});
+  page.GetTuple(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
+}
+
+RID TableIterator::FirstMappedTupleRid(page_id_t page_id) {
+  RID rid;
+  while (page_id != INVALID_PAGE_ID) {
+    TablePage page(MappedPage(page_id), Page::ReadOnlyView{});
+    if (page.GetTablePageId() != page_id) {
+      LOG_WARN("table page %d is neither on disk nor in the buffer pool", page_id);
+      throw Exception(ExceptionType::INVALID, "mapped scan reached a table page that is not on disk");
+    }
+    if (page.GetFirstTupleRid(&rid)) {
+      break;
+    }
+    page_id = page.GetNextPageId();
+  }
+  return rid;
+}
+
+const char *TableIterator::MappedPage(page_id_t page_id) {
+  if (page_id == mapped_page_id_) {
+    return mapped_page_;
+  }
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  if (!buffer_pool_manager->IsPageDirty(page_id)) {
+    mapped_page_ = mapped_pages_->GetPage(page_id);
+  } else {
+    // The disk has an old version of the page, or none at all, e.g. because the table heap was not flushed.
+    if (page_copy_ == nullptr) {
+      page_copy_ = std::make_unique<char[]>(PAGE_SIZE);
+    }
+    Page *page = buffer_pool_manager->FetchPage(page_id);
+    page->RLatch();
+    std::memcpy(page_copy_.get(), page->GetData(), PAGE_SIZE);
+    page->RUnlatch();
+    buffer_pool_manager->UnpinPage(page_id, false);
+    mapped_page_ = page_copy_.get();
+  }
+  mapped_page_id_ = page_id;
+  return mapped_page_;
+}
+
+void TableIterator::CancelReadAhead() {
+  if (read_ahead_ != nullptr) {
+    read_ahead_->cancelled_ = true;
+    read_ahead_ = nullptr;
+  }
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
@@ -11,9 +11,19 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +151,1461 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+/** DiskManager whose reads of one chosen page block until the test releases them. */
+class BlockingDiskManager : public DiskManager {
+ public:
+  BlockingDiskManager(const std::string &db_file, page_id_t blocked_page_id)
+      : DiskManager(db_file), blocked_page_id_(blocked_page_id), release_(release_promise_.get_future().share()) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == blocked_page_id_) {
+      read_started_.set_value();
+      release_.wait();
+    }
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  std::future<void> ReadStarted() { return read_started_.get_future(); }
+  void Release() { release_promise_.set_value(); }
+
+ private:
+  page_id_t blocked_page_id_;
+  std::promise<void> read_started_;
+  std::promise<void> release_promise_;
+  std::shared_future<void> release_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, MissDoesNotBlockHitsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  // Page 1 is written out first, so that the test can later read it back through a stalled disk.
+  page_id_t page_id_temp;
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    for (int i = 0; i < 2; i++) {
+      auto *page = bpm.NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+      bpm.UnpinPage(page_id_temp, true);
+    }
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  auto *disk_manager = new BlockingDiskManager(db_name, 1);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  bpm->UnpinPage(0, false);
+
+  // Scenario: two threads miss on page 1; the disk read stalls.
+  auto read_started = disk_manager->ReadStarted();
+  auto first = std::async(std::launch::async, [bpm]() { return bpm->FetchPage(1); });
+  ASSERT_EQ(std::future_status::ready, read_started.wait_for(std::chrono::seconds(10)));
+  auto second = std::async(std::launch::async, [bpm]() { return bpm->FetchPage(1); });
+
+  // Scenario: hits on other pages go through while the miss is outstanding.
+  auto hit = std::async(std::launch::async, [bpm]() { return bpm->FetchPage(0); });
+  ASSERT_EQ(std::future_status::ready, hit.wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(page0, hit.get());
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page 0"));
+
+  // Scenario: the second requester waits for the first one's read instead of issuing its own.
+  EXPECT_EQ(std::future_status::timeout, second.wait_for(std::chrono::milliseconds(50)));
+  disk_manager->Release();
+  Page *page1 = first.get();
+  ASSERT_NE(nullptr, page1);
+  EXPECT_EQ(page1, second.get());
+  EXPECT_EQ(2, page1->GetPinCount());
+  EXPECT_EQ(0, strcmp(page1->GetData(), "page 1"));
+
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_FALSE(bpm->UnpinPage(1, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentEvictionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 64;
+  const int num_threads = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: many threads fetch and dirty pages in a pool much smaller than the data, so that nearly every fetch
+  // evicts, and many evictions write back. Every page must still carry its own contents.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+      for (int i = 0; i < 2000; i++) {
+        page_id_t page_id = page_dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        page->WLatch();
+        EXPECT_EQ(page_id, std::atoi(page->GetData()));
+        page->WUnlatch();
+        bpm->UnpinPage(page_id, i % 2 == 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** DiskManager that makes every page write take a while, like a device without a write cache would. */
+class SlowWriteDiskManager : public DiskManager {
+ public:
+  explicit SlowWriteDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    DiskManager::WritePage(page_id, page_data);
+  }
+
+  /** The background flusher writes through WritePage as well. */
+  std::unique_ptr<AsyncIo> CreateAsyncIo(size_t queue_depth) override {
+    return std::make_unique<AsyncIo>(this, queue_depth);
+  }
+};
+
+/** Run a write-heavy random fetch workload and return the 99th percentile fetch latency in microseconds. */
+double WriteHeavyFetchP99(bool background_flusher) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 512;
+  const int num_fetches = 2000;
+
+  auto *disk_manager = new SlowWriteDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  if (background_flusher) {
+    bpm->RunBackgroundFlusher(buffer_pool_size / 4);
+  }
+
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+  std::vector<double> latencies;
+  for (int i = 0; i < num_fetches; i++) {
+    page_id_t page_id = page_dist(rng);
+    auto start = std::chrono::steady_clock::now();
+    Page *page = bpm->FetchPage(page_id);
+    latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    EXPECT_NE(nullptr, page);
+    // Two out of three pages touched get modified; the rest of the time goes to "query processing".
+    bpm->UnpinPage(page_id, i % 3 != 0);
+    std::this_thread::sleep_for(std::chrono::microseconds(300));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+
+  std::sort(latencies.begin(), latencies.end());
+  return latencies[latencies.size() * 99 / 100];
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundFlusherTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->RunBackgroundFlusher(2);
+
+  // Scenario: dirty more pages than the high-water mark. The flusher writes the unpinned ones without any eviction.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%zu", i);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  for (int i = 0; i < 100 && disk_manager->GetNumWrites() < static_cast<int>(buffer_pool_size) - 1; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_GE(disk_manager->GetNumWrites(), static_cast<int>(buffer_pool_size) - 1);
+
+  // Scenario: the written pages can be read back from disk.
+  bpm->StopBackgroundFlusher();
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(0, data);
+  EXPECT_EQ(0, strcmp(data, "0"));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Fetch latency of a write-heavy workload on a slow device, with and without the background flusher. Prints results
+// only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_BackgroundFlusherLatencyBenchmarkTest) {
+  double p99_without = WriteHeavyFetchP99(false);
+  double p99_with = WriteHeavyFetchP99(true);
+  std::printf("[write-heavy fetch] p99 latency: %.1f us without background flusher, %.1f us with\n", p99_without,
+              p99_with);
+}
+
+// Cost of a fetch/unpin pair that hits, touching the page header as a caller would, as the pool grows. Prints results
+// only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_HitPathBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const int num_ops = 1000000;
+
+  for (size_t buffer_pool_size : {64, 1024, 16384}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      bpm->UnpinPage(page_id_temp, false);
+    }
+
+    std::default_random_engine rng(15445);
+    std::uniform_int_distribution<page_id_t> page_dist(0, static_cast<page_id_t>(buffer_pool_size) - 1);
+    std::vector<page_id_t> page_ids(num_ops);
+    for (auto &page_id : page_ids) {
+      page_id = page_dist(rng);
+    }
+    lsn_t lsn_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t page_id : page_ids) {
+      Page *page = bpm->FetchPage(page_id);
+      lsn_sum += page->GetLSN();
+      bpm->UnpinPage(page_id, false);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0, lsn_sum);
+    std::printf("[hit path] frames=%6zu  %6.1f ns per fetch/unpin\n", buffer_pool_size, elapsed / num_ops);
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+/** DiskManager that counts page reads. */
+class ReadCountingDiskManager : public DiskManager {
+ public:
+  explicit ReadCountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    num_reads_++;
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  void ReadPages(page_id_t first_page_id, char *const *pages_data, size_t num_pages) override {
+    num_reads_++;
+    num_pages_read_ += num_pages;
+    DiskManager::ReadPages(first_page_id, pages_data, num_pages);
+  }
+
+  /** Calls to ReadPage and ReadPages. */
+  std::atomic<int> num_reads_{0};
+  /** Pages read by ReadPages. */
+  std::atomic<int> num_pages_read_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, RingStrategyTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_hot_pages = 5;
+  const int num_bulk_pages = 30;
+
+  auto *disk_manager = new ReadCountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto touch_hot_pages = [&]() {
+    for (page_id_t page_id = 0; page_id < num_hot_pages; page_id++) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), "hot"));
+      bpm->UnpinPage(page_id, false);
+    }
+  };
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_hot_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "hot");
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Scenario: a bulk load through a ring of 3 frames writes back its own pages and leaves the hot pages alone.
+  {
+    BufferAccessStrategy strategy(3);
+    for (int i = 0; i < num_bulk_pages; i++) {
+      auto *page = bpm->NewPageWithStrategy(&page_id_temp, &strategy);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+      bpm->UnpinPage(page_id_temp, true);
+    }
+  }
+  touch_hot_pages();
+  EXPECT_EQ(0, disk_manager->num_reads_);
+
+  // Scenario: a bulk scan through a ring reads back every page, and the hot pages stay resident.
+  {
+    BufferAccessStrategy strategy(3);
+    for (page_id_t page_id = num_hot_pages; page_id < num_hot_pages + num_bulk_pages; page_id++) {
+      auto *page = bpm->FetchPageWithStrategy(page_id, &strategy);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, std::stoi(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+  int num_reads = disk_manager->num_reads_;
+  touch_hot_pages();
+  EXPECT_EQ(num_reads, disk_manager->num_reads_);
+
+  // Scenario: the same scan without a ring flushes the hot pages out of the pool.
+  for (page_id_t page_id = num_hot_pages; page_id < num_hot_pages + num_bulk_pages; page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  num_reads = disk_manager->num_reads_;
+  touch_hot_pages();
+  EXPECT_EQ(num_reads + num_hot_pages, disk_manager->num_reads_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+
+/** DiskManager that counts the calls a full flush makes. */
+class FlushCountingDiskManager : public DiskManager {
+ public:
+  explicit FlushCountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    num_write_page_++;
+    DiskManager::WritePage(page_id, page_data);
+  }
+
+  void WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) override {
+    num_write_pages_++;
+    DiskManager::WritePages(first_page_id, pages_data, num_pages);
+  }
+
+  void Sync() override {
+    num_syncs_++;
+    DiskManager::Sync();
+  }
+
+  int num_write_page_{0};
+  int num_write_pages_{0};
+  int num_syncs_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 32;
+
+  auto *disk_manager = new FlushCountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%zu", i);
+  }
+  // Scenario: pages 0-9 and 20-31 are dirty, 10-19 are clean. Page 5 is pinned, which does not keep it from a flush.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    if (page_id != 5) {
+      bpm->UnpinPage(page_id, page_id < 10 || page_id >= 20);
+    }
+  }
+  bpm->UnpinPage(5, true);
+  bpm->FetchPage(5);
+
+  // Only the dirty pages are written, in two runs, and the file is synced once.
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, disk_manager->num_write_page_);
+  EXPECT_EQ(2, disk_manager->num_write_pages_);
+  EXPECT_EQ(1, disk_manager->num_syncs_);
+  EXPECT_EQ(22, disk_manager->GetNumWrites());
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(25, data);
+  EXPECT_EQ(0, strcmp(data, "25"));
+
+  // Nothing is left dirty, so a second flush writes nothing, and the flushed pages can be evicted without a write.
+  bpm->FlushAllPages();
+  EXPECT_EQ(2, disk_manager->num_write_pages_);
+  bpm->UnpinPage(5, false);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  EXPECT_EQ(0, disk_manager->num_write_page_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/** FlushCountingDiskManager that holds up the first WritePage until released, and tells whether Sync came after it. */
+class GatedWriteDiskManager : public FlushCountingDiskManager {
+ public:
+  explicit GatedWriteDiskManager(const std::string &db_file, std::shared_future<void> release)
+      : FlushCountingDiskManager(db_file), release_(std::move(release)) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (!gated_.exchange(true)) {
+      write_started_.set_value();
+      release_.wait();
+    }
+    FlushCountingDiskManager::WritePage(page_id, page_data);
+    write_done_ = true;
+  }
+
+  void Sync() override {
+    synced_after_write_ = write_done_.load();
+    FlushCountingDiskManager::Sync();
+  }
+
+  std::promise<void> write_started_;
+  std::atomic<bool> synced_after_write_{false};
+
+ private:
+  std::shared_future<void> release_;
+  std::atomic<bool> gated_{false};
+  std::atomic<bool> write_done_{false};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesDuringWriteBackTest) {
+  const std::string db_name = "test.db";
+  std::promise<void> release;
+  auto *disk_manager = new GatedWriteDiskManager(db_name, release.get_future().share());
+  auto *bpm = new BufferPoolManagerInstance(1, disk_manager);
+
+  page_id_t page_id_temp;
+  auto *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "0");
+  bpm->UnpinPage(page_id_temp, true);
+
+  // Scenario: a new page evicts page 0, whose write back is held up. A flush meanwhile has no dirty page of its own
+  // to write, but still waits for that write, and syncs after it.
+  auto evict = std::async(std::launch::async, [bpm] {
+    page_id_t page_id;
+    if (bpm->NewPage(&page_id) == nullptr) {
+      return false;
+    }
+    return bpm->UnpinPage(page_id, false);
+  });
+  disk_manager->write_started_.get_future().wait();
+  auto flush = std::async(std::launch::async, [bpm] { bpm->FlushAllPages(); });
+  EXPECT_EQ(std::future_status::timeout, flush.wait_for(std::chrono::milliseconds(50)));
+  release.set_value();
+  EXPECT_TRUE(evict.get());
+  flush.get();
+  EXPECT_EQ(1, disk_manager->num_syncs_);
+  EXPECT_TRUE(disk_manager->synced_after_write_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesDuringFlushPageTest) {
+  const std::string db_name = "test.db";
+  std::promise<void> release;
+  auto *disk_manager = new GatedWriteDiskManager(db_name, release.get_future().share());
+  auto *bpm = new BufferPoolManagerInstance(2, disk_manager);
+
+  page_id_t page_id_temp;
+  auto *page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "0");
+  bpm->UnpinPage(page_id_temp, true);
+
+  // Scenario: FlushPage has marked page 0 clean, but its write is held up. A flush meanwhile finds no dirty page, but
+  // still waits for that write, and syncs after it.
+  auto flush_page = std::async(std::launch::async, [bpm] { return bpm->FlushPage(0); });
+  disk_manager->write_started_.get_future().wait();
+  EXPECT_TRUE(bpm->IsPageDirty(0));
+  auto flush = std::async(std::launch::async, [bpm] { bpm->FlushAllPages(); });
+  EXPECT_EQ(std::future_status::timeout, flush.wait_for(std::chrono::milliseconds(50)));
+  release.set_value();
+  EXPECT_TRUE(flush_page.get());
+  flush.get();
+  EXPECT_EQ(1, disk_manager->num_syncs_);
+  EXPECT_TRUE(disk_manager->synced_after_write_);
+  EXPECT_FALSE(bpm->IsPageDirty(0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Time to flush a large, entirely dirty pool page by page and all at once. Prints results only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_FlushAllPagesBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16384;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    bpm->FlushPage(page_id);
+  }
+  double page_by_page = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    bpm->FetchPage(page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  start = std::chrono::steady_clock::now();
+  bpm->FlushAllPages();
+  double all_at_once = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::printf("[flush all] %zu dirty pages: %.1f ms page by page, %.1f ms with FlushAllPages\n", buffer_pool_size,
+              page_by_page, all_at_once);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreePageMapTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Page 0 is the header page.
+  page_id_t page_id_temp;
+  auto *header_page = static_cast<HeaderPage *>(bpm->NewPage(&page_id_temp));
+  ASSERT_EQ(HEADER_PAGE_ID, page_id_temp);
+  header_page->Init();
+  for (int i = 1; i < 8; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", i);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: deleted pages are handed out again, lowest first, instead of new ones, and come back zeroed.
+  EXPECT_TRUE(bpm->DeletePage(5));
+  EXPECT_TRUE(bpm->DeletePage(2));
+  EXPECT_EQ(2, bpm->GetNumFreePages());
+  // Deleting no page, or one that was never allocated, frees nothing.
+  EXPECT_TRUE(bpm->DeletePage(INVALID_PAGE_ID));
+  EXPECT_TRUE(bpm->DeletePage(100));
+  EXPECT_EQ(2, bpm->GetNumFreePages());
+  auto *page = bpm->NewPage(&page_id_temp);
+  EXPECT_EQ(2, page_id_temp);
+  EXPECT_EQ(0, page->GetData()[0]);
+  bpm->UnpinPage(page_id_temp, false);
+  // Even if a reused page is never written to, it must not show its old contents once it is fetched from disk. The
+  // first of these new pages reuses page 5, the others are 8 to 16.
+  for (int i = 0; i < static_cast<int>(buffer_pool_size); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  page = bpm->FetchPage(2);
+  EXPECT_EQ(0, page->GetData()[0]);
+  bpm->UnpinPage(2, false);
+
+  // Scenario: the map is saved in the header page and read back by a buffer pool opened on the same file.
+  EXPECT_TRUE(bpm->DeletePage(6));
+  EXPECT_TRUE(bpm->DeletePage(3));
+  bpm->SaveFreePageMap(header_page);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  ASSERT_TRUE(bpm->LoadFreePageMap(header_page));
+  EXPECT_EQ(2, bpm->GetNumFreePages());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(3, page_id_temp);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(6, page_id_temp);
+  // The next new page comes after every page allocated before, including page 17, which holds the map.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(18, page_id_temp);
+  page = bpm->FetchPage(7);
+  EXPECT_EQ(0, strcmp(page->GetData(), "7"));
+
+  // Scenario: pages allocated after the map was saved are not handed out again when it is read back, neither by the
+  // same buffer pool nor, once they are on disk, by one opened on the same file.
+  bpm->SaveFreePageMap(header_page);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(19, page_id_temp);
+  bpm->UnpinPage(page_id_temp, true);
+  ASSERT_TRUE(bpm->LoadFreePageMap(header_page));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(20, page_id_temp);
+  bpm->UnpinPage(page_id_temp, true);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  ASSERT_TRUE(bpm->LoadFreePageMap(header_page));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(21, page_id_temp);
+  bpm->UnpinPage(page_id_temp, true);
+
+  // Scenario: a page taken out of the map after it was saved is not handed out again when the map is read back after
+  // a crash, before the map could be saved again.
+  bpm->SaveFreePageMap(header_page);
+  EXPECT_TRUE(bpm->DeletePage(7));
+  bpm->SaveFreePageMap(header_page);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(7, page_id_temp);
+  bpm->UnpinPage(page_id_temp, true);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  ASSERT_TRUE(bpm->LoadFreePageMap(header_page));
+  EXPECT_EQ(0, bpm->GetNumFreePages());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(22, page_id_temp);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// File size and page writes of a long run of inserts and deletes. Prints results only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_FreePageChurnBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_rounds = 50;
+  const int pages_per_round = 200;
+  const int pages_kept_per_round = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Every round creates a batch of pages and deletes nearly all of them again, like a table or index under churn.
+  int num_allocated = 0;
+  std::vector<page_id_t> batch;
+  for (int round = 0; round < num_rounds; round++) {
+    batch.clear();
+    for (int i = 0; i < pages_per_round; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", round);
+      bpm->UnpinPage(page_id, true);
+      batch.push_back(page_id);
+      num_allocated++;
+    }
+    for (int i = pages_kept_per_round; i < pages_per_round; i++) {
+      EXPECT_TRUE(bpm->DeletePage(batch[i]));
+    }
+  }
+  bpm->FlushAllPages();
+  // Shut down first, which trims the space preallocated past the last page.
+  disk_manager->ShutDown();
+
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  std::printf("[page churn] %d pages allocated, %d live: file is %d KiB (%d KiB without reuse), %d page writes\n",
+              num_allocated, num_rounds * pages_kept_per_round, static_cast<int>(stat_buf.st_size / 1024),
+              num_allocated * (PAGE_SIZE / 1024), disk_manager->GetNumWrites());
+
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmUpTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.db.resident";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new ReadCountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 30; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // Leave pages 20 to 24 and 27 in the pool, 27 the most recently used.
+  for (page_id_t page_id : {20, 21, 22, 23, 24, 27}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  bpm->FlushAllPages();
+  EXPECT_TRUE(bpm->DumpResidentPages(dump_name));
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+
+  // Restart with a pool that only has room for four of the dumped pages: the hottest ones are kept.
+  disk_manager = new ReadCountingDiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(4, disk_manager);
+  EXPECT_EQ(4, bpm->WarmUp(dump_name));
+  // 27 is read on its own; 22, 23 and 24 in a single read.
+  EXPECT_EQ(2, disk_manager->num_reads_);
+  EXPECT_EQ(4, disk_manager->num_pages_read_);
+  for (page_id_t page_id : {27, 24, 23, 22}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(2, disk_manager->num_reads_);
+
+  // Warming up again finds everything resident already; a missing or foreign file warms up nothing.
+  EXPECT_EQ(0, bpm->WarmUp(dump_name));
+  EXPECT_EQ(0, bpm->WarmUp("no_such_file"));
+  EXPECT_EQ(0, bpm->WarmUp(db_name));
+  EXPECT_EQ(2, disk_manager->num_reads_);
+
+  // A periodic dump writes the file once more when stopped.
+  remove(dump_name.c_str());
+  bpm->RunResidentPageDumps(dump_name, std::chrono::hours(1));
+  bpm->StopResidentPageDumps();
+  struct stat stat_buf;
+  EXPECT_EQ(0, stat(dump_name.c_str(), &stat_buf));
+  EXPECT_EQ(sizeof(uint32_t) * 2 + sizeof(page_id_t) * 4, stat_buf.st_size);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+/** DiskManager that makes every read request take a while, like a device with a long access time. */
+class LongAccessDiskManager : public DiskManager {
+ public:
+  explicit LongAccessDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    num_pages_read_++;
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  void ReadPages(page_id_t first_page_id, char *const *pages_data, size_t num_pages) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    num_pages_read_ += num_pages;
+    DiskManager::ReadPages(first_page_id, pages_data, num_pages);
+  }
+
+  /** Pages read, one at a time or in a batch. */
+  std::atomic<int> num_pages_read_{0};
+};
+
+/** Write num_pages pages, each holding its own id, and dump the given ones as the resident set, first the hottest. */
+static void WriteWarmUpDump(const std::string &db_name, const std::string &dump_name, int num_pages,
+                            const std::vector<page_id_t> &resident) {
+  DiskManager disk_manager(db_name);
+  // A pool with room for just the resident set, which is touched last, coldest first.
+  BufferPoolManagerInstance bpm(resident.size(), &disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm.NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm.UnpinPage(page_id_temp, true);
+  }
+  for (auto it = resident.rbegin(); it != resident.rend(); ++it) {
+    ASSERT_NE(nullptr, bpm.FetchPage(*it));
+    bpm.UnpinPage(*it, false);
+  }
+  bpm.FlushAllPages();
+  ASSERT_TRUE(bpm.DumpResidentPages(dump_name));
+  disk_manager.ShutDown();
+}
+
+/** Fetch a page, check that it holds its own id, and unpin it. */
+static void FetchAndCheck(BufferPoolManagerInstance *bpm, page_id_t page_id) {
+  auto *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+  bpm->UnpinPage(page_id, false);
+}
+
+// Fetch latency right after a restart, with a cold pool and with one warmed up from a dump. Prints results only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_WarmUpBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.db.resident";
+  const size_t buffer_pool_size = 256;
+  const int num_pages = 1024;
+  const int num_fetches = 2000;
+
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    page_id_t page_id_temp;
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id_temp));
+      bpm.UnpinPage(page_id_temp, true);
+    }
+    // The hot set is a block of pages that fits in the pool.
+    for (page_id_t page_id = 300; page_id < 300 + static_cast<page_id_t>(buffer_pool_size); page_id++) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      bpm.UnpinPage(page_id, false);
+    }
+    bpm.FlushAllPages();
+    EXPECT_TRUE(bpm.DumpResidentPages(dump_name));
+    disk_manager.ShutDown();
+  }
+
+  for (bool warm_up : {false, true}) {
+    LongAccessDiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    auto start = std::chrono::steady_clock::now();
+    size_t num_warmed_up = warm_up ? bpm.WarmUp(dump_name) : 0;
+    double warm_up_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::default_random_engine rng(15445);
+    std::uniform_int_distribution<page_id_t> page_dist(300, 300 + buffer_pool_size - 1);
+    std::vector<double> latencies;
+    for (int i = 0; i < num_fetches; i++) {
+      page_id_t page_id = page_dist(rng);
+      start = std::chrono::steady_clock::now();
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+      bpm.UnpinPage(page_id, false);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total_ms = 0;
+    for (double latency : latencies) {
+      total_ms += latency / 1000;
+    }
+    std::printf("[warm-up] %-5s: %zu pages warmed up in %.1f ms, then %d fetches in %.1f ms, p99 %.1f us\n",
+                warm_up ? "warm" : "cold", num_warmed_up, warm_up_ms, num_fetches, total_ms,
+                latencies[latencies.size() * 99 / 100]);
+    disk_manager.ShutDown();
+  }
+
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentWarmUpTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.db.resident";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+
+  // Every other page, so that each one is a run of its own and warm-up takes a read per page.
+  std::vector<page_id_t> resident;
+  for (page_id_t page_id = 0; page_id < 2 * static_cast<page_id_t>(buffer_pool_size); page_id += 2) {
+    resident.push_back(page_id);
+  }
+  WriteWarmUpDump(db_name, dump_name, num_pages, resident);
+
+  auto *disk_manager = new LongAccessDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  size_t num_warmed_up = 0;
+  std::thread warm_up([&] { num_warmed_up = bpm->WarmUp(dump_name); });
+  // Requests served meanwhile always get a frame: warm-up hands each page to the replacer as soon as it is in.
+  for (page_id_t page_id = 33; page_id < 49; page_id += 2) {
+    FetchAndCheck(bpm, page_id);
+  }
+  warm_up.join();
+  EXPECT_LE(num_warmed_up, buffer_pool_size - 8);
+
+  // Warm-up only took free frames, so the pages fetched meanwhile are all still resident.
+  const int num_pages_read = disk_manager->num_pages_read_;
+  for (page_id_t page_id = 33; page_id < 49; page_id += 2) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_EQ(num_pages_read, disk_manager->num_pages_read_);
+
+  // Nothing warm-up loaded is left pinned.
+  for (page_id_t page_id = 48; page_id < 48 + static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmUpInBackgroundTest) {
+  const std::string db_name = "test.db";
+  const std::string dump_name = "test.db.resident";
+  const size_t buffer_pool_size = 16;
+
+  std::vector<page_id_t> resident;
+  for (page_id_t page_id = 0; page_id < 2 * static_cast<page_id_t>(buffer_pool_size); page_id += 2) {
+    resident.push_back(page_id);
+  }
+  WriteWarmUpDump(db_name, dump_name, 64, resident);
+
+  auto *disk_manager = new LongAccessDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->WarmUpInBackground(dump_name);
+  // Fetch the dumped pages while they are being warmed up, the coldest ones first, as warm-up does: a page is read
+  // either by warm-up or by the fetch, never by both.
+  for (auto it = resident.rbegin(); it != resident.rend(); ++it) {
+    FetchAndCheck(bpm, *it);
+  }
+  for (page_id_t page_id : resident) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_EQ(resident.size(), disk_manager->num_pages_read_);
+
+  // The destructor waits for warm-up to finish; it had no free frame left to read anything more into.
+  delete bpm;
+  EXPECT_EQ(resident.size(), disk_manager->num_pages_read_);
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove(dump_name.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager, nullptr, ReplacerType::LRU, 20);
+  EXPECT_EQ(10, bpm->GetPoolSize());
+  EXPECT_EQ(20, bpm->GetMaxPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(21));
+
+  // Growing makes room for more pinned pages.
+  std::vector<Page *> pages;
+  page_id_t page_id_temp;
+  for (int i = 0; i < 10; i++) {
+    pages.push_back(bpm->NewPage(&page_id_temp));
+    ASSERT_NE(nullptr, pages.back());
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->Resize(20));
+  EXPECT_EQ(20, bpm->GetPoolSize());
+  for (int i = 10; i < 20; i++) {
+    pages.push_back(bpm->NewPage(&page_id_temp));
+    ASSERT_NE(nullptr, pages.back());
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  for (page_id_t page_id = 0; page_id < 20; page_id++) {
+    snprintf(pages[page_id]->GetData(), PAGE_SIZE, "page %d", page_id);
+    // Keep page 15 pinned.
+    if (page_id != 15) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  }
+
+  // Shrinking waits for the page pinned in a frame that goes away.
+  auto shrunk = std::async(std::launch::async, [bpm] { return bpm->Resize(5); });
+  EXPECT_EQ(std::future_status::timeout, shrunk.wait_for(std::chrono::milliseconds(50)));
+  EXPECT_STREQ("page 15", pages[15]->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(15, true));
+  EXPECT_TRUE(shrunk.get());
+  EXPECT_EQ(5, bpm->GetPoolSize());
+
+  // Every page survived, and no more than five fit at once.
+  for (page_id_t page_id = 0; page_id < 20; page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_LT(page - bpm->GetPages(), 5);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id = 0; page_id < 5; page_id++) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(5));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentResizeTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 200;
+  const int num_threads = 4;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager, nullptr, ReplacerType::LRU, 128);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+
+  // Readers and writers keep going while the pool grows and shrinks under them.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &done, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+      while (!done) {
+        page_id_t page_id = page_dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        page->WLatch();
+        EXPECT_EQ(page_id, std::stoi(page->GetData()));
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        page->WUnlatch();
+        bpm->UnpinPage(page_id, true);
+      }
+    });
+  }
+  for (size_t pool_size : {16, 128, 8, 100, 32, 64}) {
+    EXPECT_TRUE(bpm->Resize(pool_size));
+    EXPECT_EQ(pool_size, bpm->GetPoolSize());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, MetricsTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(3, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  bpm->UnpinPage(0, true);
+  bpm->UnpinPage(1, false);
+  bpm->UnpinPage(2, false);
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  bpm->UnpinPage(0, false);
+  // Evicts page 1, then page 2 for page 1, then the dirty page 0 for page 2.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  bpm->UnpinPage(page_id_temp, false);
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  bpm->UnpinPage(1, false);
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  BufferPoolMetrics metrics = bpm->GetMetrics();
+  EXPECT_EQ(3, metrics.fetch_hits_);
+  EXPECT_EQ(2, metrics.fetch_misses_);
+  EXPECT_DOUBLE_EQ(0.6, metrics.HitRatio());
+  EXPECT_EQ(4, metrics.new_pages_);
+  EXPECT_EQ(3, metrics.evictions_);
+  EXPECT_EQ(1, metrics.dirty_write_backs_);
+  EXPECT_EQ(1, metrics.victim_failures_);
+  EXPECT_EQ(0, metrics.latch_wait_ns_);
+  EXPECT_EQ(3, metrics.pinned_frames_high_water_);
+
+  // Flushes count as write-backs too.
+  bpm->UnpinPage(2, true);
+  bpm->FlushAllPages();
+  EXPECT_EQ(2, bpm->GetMetrics().dirty_write_backs_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CompressedCacheTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new ReadCountingDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(3, disk_manager);
+  bpm->EnableCompressedCache(1 << 20);
+  CompressedPageCache *cache = bpm->GetCompressedCache();
+  ASSERT_NE(nullptr, cache);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 6; i++) {
+    Page *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  // Pages 0 to 2 were written back when evicted, and kept compressed.
+  EXPECT_EQ(3, cache->GetNumPages());
+
+  Page *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 0", page->GetData());
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  bpm->UnpinPage(0, false);
+  // Page 0 left the cache, and page 3 took its place.
+  EXPECT_EQ(3, cache->GetNumPages());
+
+  // A deleted page must not come back from the cache.
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_EQ(2, cache->GetNumPages());
+
+  // A page that does not compress is not kept: it takes the place of page 1 and is read back from disk.
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  char random_data[PAGE_SIZE];
+  for (char &c : random_data) {
+    c = static_cast<char>(byte_dist(rng));
+  }
+  page = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, page_id_temp);
+  memcpy(page->GetData(), random_data, PAGE_SIZE);
+  bpm->UnpinPage(1, true);
+  for (page_id_t page_id : {2, 3, 4}) {
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(0, disk_manager->num_reads_);
+  page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, memcmp(page->GetData(), random_data, PAGE_SIZE));
+  EXPECT_EQ(1, disk_manager->num_reads_);
+  bpm->UnpinPage(1, false);
+
+  BufferPoolMetrics metrics = bpm->GetMetrics();
+  EXPECT_EQ(5, metrics.fetch_misses_);
+  EXPECT_EQ(4, metrics.compressed_cache_hits_);
+  EXPECT_DOUBLE_EQ(0.8, metrics.EffectiveHitRatio());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// Random fetches over a working set four times the size of the pool, of sparsely filled pages, on a device with a long
+// access time, with and without a compressed cache. Prints results only.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_CompressedCacheBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 256;
+  const int num_fetches = 4000;
+
+  for (size_t cache_capacity : {size_t{0}, size_t{1} << 20}) {
+    LongAccessDiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager);
+    bpm.EnableCompressedCache(cache_capacity);
+    std::default_random_engine rng(15445);
+    std::uniform_int_distribution<int> byte_dist(0, 255);
+    page_id_t page_id_temp;
+    for (int i = 0; i < num_pages; i++) {
+      Page *page = bpm.NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      // A handful of tuples, each a random key followed by a few repetitive fields.
+      for (size_t offset = PAGE_SIZE - 64; offset >= PAGE_SIZE - 64 * 12; offset -= 64) {
+        for (size_t j = 0; j < 64; j++) {
+          page->GetData()[offset + j] = static_cast<char>(j < 8 ? byte_dist(rng) : 'a' + j % 7);
+        }
+      }
+      bpm.UnpinPage(page_id_temp, true);
+    }
+    const BufferPoolMetrics before = bpm.GetMetrics();
+
+    std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+    std::vector<double> latencies;
+    for (int i = 0; i < num_fetches; i++) {
+      const page_id_t page_id = page_dist(rng);
+      const auto start = std::chrono::steady_clock::now();
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+      bpm.UnpinPage(page_id, false);
+    }
+    BufferPoolMetrics metrics = bpm.GetMetrics();
+    metrics.fetch_hits_ -= before.fetch_hits_;
+    metrics.fetch_misses_ -= before.fetch_misses_;
+    metrics.compressed_cache_hits_ -= before.compressed_cache_hits_;
+    std::sort(latencies.begin(), latencies.end());
+    double total_us = 0;
+    for (double latency : latencies) {
+      total_us += latency;
+    }
+    CompressedPageCache *cache = bpm.GetCompressedCache();
+    std::printf(
+        "[compressed cache] %-9s: hit ratio %.2f, effective %.2f, mean fetch %.1f us, p99 %.1f us, cache %zu bytes\n",
+        cache == nullptr ? "disk only" : "cached", metrics.HitRatio(), metrics.EffectiveHitRatio(),
+        total_us / num_fetches, latencies[latencies.size() * 99 / 100], cache == nullptr ? 0 : cache->GetSize());
+    disk_manager.ShutDown();
+  }
+
+  remove(db_name.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FailedPrefetchKeepsVictimOrderTest) {
+  const std::string db_name = "test.db";
+  const auto no_next_page = [](const char *page_data) { return INVALID_PAGE_ID; };
+
+  for (ReplacerType replacer_type : {ReplacerType::LRU, ReplacerType::LRU_K, ReplacerType::CLOCK}) {
+    ReadCountingDiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(3, &disk_manager, nullptr, replacer_type);
+    page_id_t page_id_temp;
+    for (int i = 0; i < 3; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id_temp));
+      bpm.UnpinPage(page_id_temp, true);
+    }
+
+    // Every frame is dirty, so a prefetch gets none, and has to leave page 0 the next victim.
+    page_id_t next_page_id;
+    EXPECT_FALSE(bpm.PrefetchPage(3, no_next_page, &next_page_id));
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id_temp));
+    bpm.UnpinPage(page_id_temp, false);
+    for (page_id_t page_id : {1, 2}) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      bpm.UnpinPage(page_id, false);
+    }
+    EXPECT_EQ(0, disk_manager.num_reads_) << static_cast<int>(replacer_type);
+    disk_manager.ShutDown();
+  }
+  remove(db_name.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AsyncReadAheadTest) {
+  const std::string db_name = "test.db";
+  const size_t num_chains = 4;
+  const size_t chain_length = 16;
+  auto *disk_manager = new DiskManager(db_name);
+
+  // Chain c is made of pages c, c + num_chains, c + 2 * num_chains, ...; each page starts with the id of the next.
+  {
+    BufferPoolManagerInstance writer(num_chains * chain_length, disk_manager);
+    page_id_t page_id;
+    for (size_t i = 0; i < num_chains * chain_length; i++) {
+      Page *page = writer.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      const page_id_t next = i + num_chains < num_chains * chain_length ? page_id + num_chains : INVALID_PAGE_ID;
+      memcpy(page->GetData(), &next, sizeof(next));
+      memcpy(page->GetData() + sizeof(next), &page_id, sizeof(page_id));
+      writer.UnpinPage(page_id, true);
+    }
+    writer.FlushAllPages();
+  }
+
+  auto *bpm = new BufferPoolManagerInstance(num_chains * chain_length + 8, disk_manager);
+  bpm->RegisterFramesForReadAhead();
+  auto next_page = [](const char *page_data) {
+    page_id_t next;
+    memcpy(&next, page_data, sizeof(next));
+    return next;
+  };
+  std::vector<std::shared_ptr<ReadAheadRequest>> requests;
+  for (size_t c = 0; c < num_chains; c++) {
+    requests.push_back(bpm->ReadAhead(static_cast<page_id_t>(c), chain_length, next_page, nullptr));
+    ASSERT_NE(nullptr, requests.back());
+  }
+  for (const auto &request : requests) {
+    while (!request->finished_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // Every page of every chain is resident, with the contents that were written.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_chains * chain_length); page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    page_id_t stored;
+    memcpy(&stored, page->GetData() + sizeof(page_id_t), sizeof(stored));
+    EXPECT_EQ(page_id, stored);
+    bpm->UnpinPage(page_id, false);
+  }
+  BufferPoolMetrics metrics = bpm->GetMetrics();
+  EXPECT_EQ(num_chains * chain_length, metrics.fetch_hits_);
+  EXPECT_EQ(0, metrics.fetch_misses_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// A scan issues each read-ahead window before the previous one is done, so windows overlap. The worker must not wait
+// for a page it has queued itself and not yet submitted, whether it reads through io_uring or not.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, OverlappingReadAheadTest) {
+  const std::string db_name = "test.db";
+  const size_t chain_length = 256;
+  auto *disk_manager = new DiskManager(db_name);
+  {
+    BufferPoolManagerInstance writer(chain_length, disk_manager);
+    page_id_t page_id;
+    for (size_t i = 0; i < chain_length; i++) {
+      Page *page = writer.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      const page_id_t next = i + 1 < chain_length ? page_id + 1 : INVALID_PAGE_ID;
+      memcpy(page->GetData(), &next, sizeof(next));
+      writer.UnpinPage(page_id, true);
+    }
+    writer.FlushAllPages();
+  }
+  auto next_page = [](const char *page_data) {
+    page_id_t next;
+    memcpy(&next, page_data, sizeof(next));
+    return next;
+  };
+
+  for (int round = 0; round < 20; round++) {
+    auto *bpm = new BufferPoolManagerInstance(chain_length + 8, disk_manager);
+    bpm->RegisterFramesForReadAhead();
+    // Windows of 16 pages, each starting halfway into the one before, all in the queue at once.
+    std::vector<std::shared_ptr<ReadAheadRequest>> requests;
+    for (page_id_t first = 0; first + 16 <= static_cast<page_id_t>(chain_length); first += 8) {
+      requests.push_back(bpm->ReadAhead(first, 16, next_page, nullptr));
+      ASSERT_NE(nullptr, requests.back());
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (const auto &request : requests) {
+      while (!request->finished_ && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      ASSERT_TRUE(request->finished_) << "read-ahead stuck in round " << round;
+    }
+    // Whatever was loaded can be fetched; nothing is left in I/O.
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(chain_length); page_id++) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id + 1 < static_cast<page_id_t>(chain_length) ? page_id + 1 : INVALID_PAGE_ID,
+                next_page(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+    delete bpm;
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DataFilePlacementTest) {
+  const std::vector<std::string> db_files = {"test.db", "test_1.db"};
+  auto *disk_manager = new DiskManager(db_files, 4);
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  page_id_t page_id;
+  auto new_page = [&](data_file_id_t data_file) {
+    Page *page = bpm->NewPageInDataFile(&page_id, data_file);
+    EXPECT_NE(nullptr, page);
+    bpm->UnpinPage(page_id, false);
+    return page_id;
+  };
+
+  // Pages 0-3 are in the first file; they are skipped, and left for whoever wants a page there.
+  EXPECT_EQ(4, new_page(1));
+  EXPECT_EQ(4, bpm->GetNumFreePages());
+  EXPECT_EQ(5, new_page(1));
+  EXPECT_EQ(0, new_page(ANY_DATA_FILE));
+  EXPECT_EQ(1, new_page(0));
+  EXPECT_EQ(6, new_page(1));
+  EXPECT_EQ(7, new_page(1));
+  EXPECT_EQ(12, new_page(1));
+  EXPECT_EQ(6, bpm->GetNumFreePages());
+  EXPECT_EQ(2, new_page(0));
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // With one-page stripes, the page ids of the second of two instances never fall in the first file; it gets a page
+  // elsewhere rather than none.
+  disk_manager = new DiskManager(db_files, 1);
+  bpm = new BufferPoolManagerInstance(16, 2, 1, disk_manager);
+  EXPECT_EQ(1, new_page(0));
+  EXPECT_EQ(0, bpm->GetNumFreePages());
+
+  disk_manager->ShutDown();
+  for (const auto &db_file : db_files) {
+    remove(db_file.c_str());
+  }
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -10,16 +10,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +64,127 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, EvictTest) {
+  ClockReplacer clock_replacer(7);
+
+  // Scenario: only evictable frames can be evicted, and each only once.
+  for (frame_id_t i = 1; i <= 3; i++) {
+    clock_replacer.Unpin(i);
+  }
+  EXPECT_TRUE(clock_replacer.Evict(2));
+  EXPECT_FALSE(clock_replacer.Evict(2));
+  EXPECT_FALSE(clock_replacer.Evict(4));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  // Scenario: an evicted frame is no longer a victim candidate.
+  int value;
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, FilteredVictimTest) {
+  ClockReplacer clock_replacer(7);
+
+  // Scenario: a victim is only taken among the frames accepted; the others are passed over.
+  for (frame_id_t i = 1; i <= 4; i++) {
+    clock_replacer.Unpin(i);
+  }
+  int value;
+  ASSERT_TRUE(clock_replacer.Victim(&value, [](frame_id_t frame_id) { return frame_id % 2 == 0; }));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(clock_replacer.Victim(&value, [](frame_id_t frame_id) { return false; }));
+  EXPECT_EQ(3, clock_replacer.Size());
+
+  // Scenario: they are still there to be victims.
+  std::vector<frame_id_t> victims(3);
+  for (frame_id_t &victim : victims) {
+    ASSERT_TRUE(clock_replacer.Victim(&victim));
+  }
+  std::sort(victims.begin(), victims.end());
+  EXPECT_EQ(std::vector<frame_id_t>({1, 3, 4}), victims);
+}
+
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, ConcurrentTest) {
+  const size_t num_frames = 64;
+  const int num_threads = 8;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread owns a disjoint set of frames and cycles them through unpin/pin, while stealing frames
+  // from the other threads as victims. Once every thread has pinned its frames again, nothing may be evictable.
+  std::atomic<size_t> num_victims{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid]() {
+      for (int round = 0; round < 1000; round++) {
+        for (size_t i = tid; i < num_frames; i += num_threads) {
+          clock_replacer.Unpin(static_cast<frame_id_t>(i));
+        }
+        frame_id_t victim;
+        if (clock_replacer.Victim(&victim)) {
+          EXPECT_LT(static_cast<size_t>(victim), num_frames);
+          num_victims++;
+        }
+        for (size_t i = tid; i < num_frames; i += num_threads) {
+          clock_replacer.Pin(static_cast<frame_id_t>(i));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_GT(num_victims.load(), 0);
+}
+
+/** Hit-path throughput: each thread pins and unpins random frames, with an occasional eviction. */
+double ReplacerThroughput(Replacer *replacer, size_t num_frames, int num_threads, size_t ops_per_thread) {
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer->Unpin(static_cast<frame_id_t>(i));
+  }
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([=]() {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<frame_id_t> frame_dist(0, static_cast<frame_id_t>(num_frames) - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        frame_id_t frame_id = frame_dist(rng);
+        replacer->Pin(frame_id);
+        replacer->Unpin(frame_id);
+        if (i % 64 == 0 && replacer->Victim(&frame_id)) {
+          replacer->Unpin(frame_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(ops_per_thread) * num_threads / elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, DISABLED_ThroughputBenchmarkTest) {
+  const size_t num_frames = 10000;
+  const size_t ops_per_thread = 50000;
+  for (int num_threads : {1, 8, 32}) {
+    ClockReplacer clock_replacer(num_frames);
+    LRUReplacer lru_replacer(num_frames);
+    double clock_ops = ReplacerThroughput(&clock_replacer, num_frames, num_threads, ops_per_thread);
+    double lru_ops = ReplacerThroughput(&lru_replacer, num_frames, num_threads, ops_per_thread);
+    std::printf("[replacer] threads=%2d  clock %8.2f Mops/s  lru %8.2f Mops/s\n", num_threads, clock_ops / 1e6,
+                lru_ops / 1e6);
+    EXPECT_EQ(num_frames, clock_replacer.Size());
+    EXPECT_EQ(num_frames, lru_replacer.Size());
+  }
+}
+
 }  // namespace bustub
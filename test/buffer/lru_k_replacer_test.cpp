@@ -0,0 +1,241 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: access frames 1-6 once each, then frame 1 again. Only frame 1 has two accesses.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_replacer.Pin(i);
+  }
+  lru_replacer.Pin(1);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frames with a single access have infinite backward K-distance and go first, oldest first.
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: pinning removes a frame from consideration, pinning an evicted frame only records an access.
+  lru_replacer.Pin(5);
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: frame 5 now has two accesses, but its second-to-last one is later than frame 1's.
+  lru_replacer.Unpin(5);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, EvictTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: only evictable frames can be evicted, and each only once.
+  for (frame_id_t i = 1; i <= 3; i++) {
+    lru_replacer.Unpin(i);
+  }
+  EXPECT_TRUE(lru_replacer.Evict(2));
+  EXPECT_FALSE(lru_replacer.Evict(2));
+  EXPECT_FALSE(lru_replacer.Evict(4));
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: an evicted frame is no longer a victim candidate.
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, FilteredVictimTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: a victim is only taken among the frames accepted; the others are passed over.
+  for (frame_id_t i = 1; i <= 4; i++) {
+    lru_replacer.Unpin(i);
+  }
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value, [](frame_id_t frame_id) { return frame_id % 2 == 0; }));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value, [](frame_id_t frame_id) { return false; }));
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: they are where they were, so the victims come in the usual order.
+  for (frame_id_t expected : {1, 3, 4}) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_replacer(4, 2, 3);
+
+  // Scenario: frame 0 is touched twice in a row. Both accesses fall into one correlated period, so it still only
+  // has a single reference in its history. Frame 1 is touched twice, far enough apart.
+  lru_replacer.Pin(0);
+  lru_replacer.Pin(0);
+  lru_replacer.Pin(1);
+  lru_replacer.Pin(2);
+  lru_replacer.Pin(3);
+  lru_replacer.Pin(2);
+  lru_replacer.Pin(3);
+  lru_replacer.Pin(1);
+  for (frame_id_t i = 0; i < 4; i++) {
+    lru_replacer.Unpin(i);
+  }
+
+  // Frame 0 goes first despite having been accessed as often as frame 1.
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  // Frame 1's last access is inside its correlated period, so frames 2 and 3 are preferred.
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  // When nothing else is left, the period is ignored.
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: frame 0's burst at times 1 and 3 is followed by a reference at 7, which makes the burst its second most
+  // recent reference, shifted to time 3. Frame 1, referenced at 2 and 6, has the larger backward K-distance.
+  LRUKReplacer burst_replacer(4, 2, 2);
+  burst_replacer.Pin(0);
+  burst_replacer.Pin(1);
+  burst_replacer.Pin(0);
+  burst_replacer.Pin(2);
+  burst_replacer.Pin(3);
+  burst_replacer.Pin(1);
+  burst_replacer.Pin(0);
+  burst_replacer.Pin(2);
+  burst_replacer.Pin(3);
+  burst_replacer.Pin(2);
+  burst_replacer.Unpin(0);
+  burst_replacer.Unpin(1);
+  ASSERT_TRUE(burst_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(burst_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+}
+
+/** Minimal page cache on top of a replacer, for measuring hit ratios without disk I/O. */
+class SimulatedPool {
+ public:
+  SimulatedPool(size_t pool_size, std::unique_ptr<Replacer> replacer)
+      : pool_size_(pool_size), replacer_(std::move(replacer)) {}
+
+  /** Touch a page, return true on a hit. */
+  bool Access(page_id_t page_id) {
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end()) {
+      replacer_->Pin(it->second);
+      replacer_->Unpin(it->second);
+      return true;
+    }
+    frame_id_t frame_id;
+    if (frames_.size() < pool_size_) {
+      frame_id = static_cast<frame_id_t>(frames_.size());
+      frames_.push_back(page_id);
+    } else {
+      EXPECT_TRUE(replacer_->Victim(&frame_id));
+      page_table_.erase(frames_[frame_id]);
+      frames_[frame_id] = page_id;
+    }
+    page_table_[page_id] = frame_id;
+    replacer_->Pin(frame_id);
+    replacer_->Unpin(frame_id);
+    return false;
+  }
+
+ private:
+  size_t pool_size_;
+  std::unique_ptr<Replacer> replacer_;
+  std::vector<page_id_t> frames_;
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+};
+
+/** Zipf-distributed lookups over a hot table, interrupted by full scans of a table four times the pool size. */
+double ScanPlusZipfHitRatio(SimulatedPool *pool, size_t pool_size) {
+  const size_t num_hot_pages = pool_size * 4;
+  const size_t num_scan_pages = pool_size * 4;
+  const page_id_t scan_base = 1 << 24;
+
+  std::vector<double> cdf(num_hot_pages);
+  double sum = 0;
+  for (size_t i = 0; i < num_hot_pages; i++) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), 0.99);
+    cdf[i] = sum;
+  }
+  std::default_random_engine rng(15445);
+  std::uniform_real_distribution<double> uniform(0, sum);
+
+  size_t lookups = 0;
+  size_t hits = 0;
+  for (int round = 0; round < 20; round++) {
+    for (size_t i = 0; i < pool_size * 10; i++) {
+      auto page_id = static_cast<page_id_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin());
+      hits += pool->Access(page_id) ? 1 : 0;
+      lookups++;
+    }
+    for (size_t i = 0; i < num_scan_pages; i++) {
+      pool->Access(scan_base + static_cast<page_id_t>(i));
+    }
+  }
+  return static_cast<double>(hits) / static_cast<double>(lookups);
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerTest, ScanPlusZipfHitRatioTest) {
+  const size_t pool_size = 1000;
+
+  SimulatedPool lru_pool(pool_size, std::make_unique<LRUReplacer>(pool_size));
+  SimulatedPool lru_k_pool(pool_size, std::make_unique<LRUKReplacer>(pool_size, 2));
+  double lru_hit_ratio = ScanPlusZipfHitRatio(&lru_pool, pool_size);
+  double lru_k_hit_ratio = ScanPlusZipfHitRatio(&lru_k_pool, pool_size);
+
+  std::printf("[scan+zipf] point lookup hit ratio: LRU %.3f, LRU-2 %.3f\n", lru_hit_ratio, lru_k_hit_ratio);
+  EXPECT_GT(lru_k_hit_ratio, lru_hit_ratio);
+}
+
+}  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -59,4 +61,78 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// NOLINTNEXTLINE
+TEST(LRUReplacerTest, EvictTest) {
+  LRUReplacer lru_replacer(7);
+
+  // Scenario: only evictable frames can be evicted, and each only once.
+  for (frame_id_t i = 1; i <= 3; i++) {
+    lru_replacer.Unpin(i);
+  }
+  EXPECT_TRUE(lru_replacer.Evict(2));
+  EXPECT_FALSE(lru_replacer.Evict(2));
+  EXPECT_FALSE(lru_replacer.Evict(4));
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: an evicted frame is no longer a victim candidate.
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  ASSERT_TRUE(lru_replacer.Victim(&value));
+  EXPECT_NE(2, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(LRUReplacerTest, FilteredVictimTest) {
+  LRUReplacer lru_replacer(7);
+
+  // Scenario: a victim is only taken among the frames accepted; the others are passed over.
+  for (frame_id_t i = 1; i <= 4; i++) {
+    lru_replacer.Unpin(i);
+  }
+  int value;
+  ASSERT_TRUE(lru_replacer.Victim(&value, [](frame_id_t frame_id) { return frame_id % 2 == 0; }));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_replacer.Victim(&value, [](frame_id_t frame_id) { return false; }));
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: they are where they were, so the victims come in the usual order.
+  for (frame_id_t expected : {1, 3, 4}) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+}
+
+// Per-operation cost of Pin/Unpin/Victim should stay flat as the number of frames grows.
+// NOLINTNEXTLINE
+TEST(LRUReplacerTest, DISABLED_ScalingBenchmarkTest) {
+  const size_t num_ops = 1000000;
+  std::default_random_engine rng(15445);
+
+  for (size_t num_frames = 1000; num_frames <= 1000000; num_frames *= 10) {
+    LRUReplacer lru_replacer(num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+      lru_replacer.Unpin(static_cast<frame_id_t>(i));
+    }
+    std::uniform_int_distribution<frame_id_t> frame_dist(0, static_cast<frame_id_t>(num_frames) - 1);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_ops; i++) {
+      // Mimic a buffer pool hit (pin, then unpin) interleaved with an occasional eviction.
+      frame_id_t frame_id = frame_dist(rng);
+      lru_replacer.Pin(frame_id);
+      lru_replacer.Unpin(frame_id);
+      if (i % 8 == 0 && lru_replacer.Victim(&frame_id)) {
+        lru_replacer.Unpin(frame_id);
+      }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(num_frames, lru_replacer.Size());
+    std::printf("[LRUReplacer] frames=%8zu  %6.1f ns/op\n", num_frames,
+                static_cast<double>(elapsed.count()) / static_cast<double>(num_ops));
+  }
+}
+
 }  // namespace bustub
@@ -11,9 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -21,7 +24,7 @@ namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
-TEST(ParallelBufferPoolManagerTest, DISABLED_BinaryDataTest) {
+TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
@@ -88,7 +91,7 @@ TEST(ParallelBufferPoolManagerTest, DISABLED_BinaryDataTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(ParallelBufferPoolManagerTest, DISABLED_SampleTest) {
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
@@ -151,4 +154,148 @@ TEST(ParallelBufferPoolManagerTest, DISABLED_SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FreePageMapTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 12; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+
+  // Scenario: a deleted page is reused only by the instance it belongs to, so page ids keep routing correctly.
+  EXPECT_TRUE(bpm->DeletePage(4));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+    EXPECT_TRUE(page_id_temp == 4 || page_id_temp >= 12);
+  }
+  auto *page = bpm->FetchPage(4);
+  ASSERT_NE(nullptr, page);
+  bpm->UnpinPage(4, false);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// Aggregate hit-path throughput of fetch/unpin from many threads, as the number of instances grows.
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 4, disk_manager, nullptr, ReplacerType::LRU, 8);
+  EXPECT_EQ(12, bpm->GetPoolSize());
+  EXPECT_FALSE(bpm->Resize(25));
+  EXPECT_FALSE(bpm->Resize(2));
+  EXPECT_EQ(12, bpm->GetPoolSize());
+
+  // 20 frames: 7, 7 and 6.
+  EXPECT_TRUE(bpm->Resize(20));
+  EXPECT_EQ(20, bpm->GetPoolSize());
+  std::vector<page_id_t> page_ids(18);
+  for (auto &page_id : page_ids) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (page_id_t page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_TRUE(bpm->Resize(3));
+  EXPECT_EQ(3, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, MetricsTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 2, disk_manager);
+
+  // Six pinned pages fill every instance; fetching them again is all hits, spread over the instances.
+  std::vector<page_id_t> page_ids(6);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_EQ(6, bpm->GetMetrics().pinned_frames_high_water_);
+  for (page_id_t page_id : page_ids) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  BufferPoolMetrics metrics = bpm->GetMetrics();
+  EXPECT_EQ(6, metrics.new_pages_);
+  EXPECT_EQ(6, metrics.fetch_hits_);
+  EXPECT_EQ(0, metrics.fetch_misses_);
+  EXPECT_EQ(6, metrics.pinned_frames_high_water_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// Throughput of fetches that hit, from several threads, as the same pool is split over more instances. Prints results
+// only.
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ContentionBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t total_pool_size = 256;
+  const int num_threads = 8;
+  const int ops_per_thread = 20000;
+
+  for (size_t num_instances : {1, 2, 4, 8}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new ParallelBufferPoolManager(num_instances, total_pool_size / num_instances, disk_manager);
+
+    // Fill the pool completely, so that every fetch below is a hit.
+    std::vector<page_id_t> page_ids;
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < total_pool_size; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+      bpm->UnpinPage(page_id_temp, false);
+      page_ids.push_back(page_id_temp);
+    }
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([bpm, &page_ids, tid]() {
+        std::default_random_engine rng(tid);
+        std::uniform_int_distribution<size_t> page_dist(0, page_ids.size() - 1);
+        for (int i = 0; i < ops_per_thread; i++) {
+          page_id_t page_id = page_ids[page_dist(rng)];
+          EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+          bpm->UnpinPage(page_id, false);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[parallel bpm] instances=%zu  %8.2f Mfetch/s\n", num_instances,
+                static_cast<double>(num_threads) * ops_per_thread / elapsed / 1e6);
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util_test.cpp
+//
+// Identification: test/common/compression_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/compression_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+/** Compress and decompress data, and check that it comes back unchanged. @return the compressed size */
+size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed(CompressionUtil::MaxCompressedSize(data.size()));
+  const size_t size = CompressionUtil::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  EXPECT_NE(0, size);
+  std::vector<char> decompressed(data.size());
+  EXPECT_TRUE(CompressionUtil::Decompress(compressed.data(), size, decompressed.data(), decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+  return size;
+}
+
+// NOLINTNEXTLINE
+TEST(CompressionUtilTest, RoundTripTest) {
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+
+  // An empty page compresses to a few bytes.
+  std::vector<char> data(PAGE_SIZE, 0);
+  EXPECT_LT(RoundTrip(data), 64);
+
+  // A page of a few tuples with repeated fields compresses well.
+  for (size_t offset = PAGE_SIZE - 100; offset >= 100; offset -= 100) {
+    for (size_t i = 0; i < 40; i++) {
+      data[offset + i] = static_cast<char>(i < 8 ? byte_dist(rng) : 'a' + i % 4);
+    }
+  }
+  EXPECT_LT(RoundTrip(data), PAGE_SIZE / 2);
+
+  // Random data does not compress, but still round trips within MaxCompressedSize.
+  for (char &c : data) {
+    c = static_cast<char>(byte_dist(rng));
+  }
+  EXPECT_LE(RoundTrip(data), CompressionUtil::MaxCompressedSize(PAGE_SIZE));
+
+  // Long literal runs and long matches need extra length bytes.
+  std::vector<char> mixed(1000);
+  for (size_t i = 0; i < mixed.size(); i++) {
+    mixed[i] = static_cast<char>(i < 600 ? byte_dist(rng) : 'x');
+  }
+  RoundTrip(mixed);
+  RoundTrip(std::vector<char>());
+  RoundTrip(std::vector<char>{'a', 'b', 'c'});
+}
+
+// NOLINTNEXTLINE
+TEST(CompressionUtilTest, LimitsTest) {
+  std::vector<char> data(PAGE_SIZE);
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  for (char &c : data) {
+    c = static_cast<char>(byte_dist(rng));
+  }
+  std::vector<char> compressed(CompressionUtil::MaxCompressedSize(PAGE_SIZE));
+
+  // Output that does not fit is reported, not truncated.
+  EXPECT_EQ(0, CompressionUtil::Compress(data.data(), data.size(), compressed.data(), PAGE_SIZE / 2));
+
+  // Corrupt or truncated input is rejected.
+  memset(data.data() + PAGE_SIZE / 2, 0, PAGE_SIZE / 2);
+  const size_t size = CompressionUtil::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0, size);
+  std::vector<char> decompressed(PAGE_SIZE);
+  EXPECT_FALSE(CompressionUtil::Decompress(compressed.data(), size / 2, decompressed.data(), PAGE_SIZE));
+  EXPECT_FALSE(CompressionUtil::Decompress(compressed.data(), size, decompressed.data(), PAGE_SIZE - 1));
+  std::mt19937 corrupt_rng(15445);
+  for (int i = 0; i < 1000; i++) {
+    std::vector<char> garbage(size);
+    for (char &c : garbage) {
+      c = static_cast<char>(corrupt_rng());
+    }
+    // Garbage must never make Decompress read or write out of bounds; the result itself does not matter.
+    CompressionUtil::Decompress(garbage.data(), garbage.size(), decompressed.data(), PAGE_SIZE);
+  }
+  // One literal, then a match 5 bytes back.
+  const char bad_offset[] = {0x10, 'a', 0x05, 0x00};
+  EXPECT_FALSE(CompressionUtil::Decompress(bad_offset, sizeof(bad_offset), decompressed.data(), 5));
+}
+
+}  // namespace bustub
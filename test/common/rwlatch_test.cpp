@@ -10,7 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <thread>  // NOLINT
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <shared_mutex>  // NOLINT
+#include <thread>        // NOLINT
 #include <vector>
 
 #include "common/rwlatch.h"
@@ -18,6 +23,7 @@
 
 namespace bustub {
 
+template <typename Latch = ReaderWriterLatch>
 class Counter {
  public:
   Counter() = default;
@@ -36,13 +42,55 @@ class Counter {
 
  private:
   int count_{0};
-  ReaderWriterLatch mutex_{};
+  Latch mutex_{};
 };
 
+/** std::shared_mutex behind the ReaderWriterLatch interface, as a baseline for the benchmark. */
+class StdSharedMutex {
+ public:
+  void WLock() { mutex_.lock(); }
+  void WUnlock() { mutex_.unlock(); }
+  void RLock() { mutex_.lock_shared(); }
+  void RUnlock() { mutex_.unlock_shared(); }
+
+ private:
+  std::shared_mutex mutex_;
+};
+
+/**
+ * Run num_threads threads doing ops_per_thread latched operations each on one Counter, of which write_percent percent
+ * are writes, and print the throughput.
+ */
+template <typename Latch>
+void RunLatchBenchmark(const char *name, int num_threads, int ops_per_thread, int write_percent) {
+  Counter<Latch> counter{};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&counter, tid, ops_per_thread, write_percent] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<int> dist(0, 99);
+      for (int i = 0; i < ops_per_thread; i++) {
+        if (dist(rng) < write_percent) {
+          counter.Add(1);
+        } else {
+          counter.Read();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("[rwlatch] %-16s threads=%2d writes=%2d%% %12.0f ops/s\n", name, num_threads, write_percent,
+         num_threads * ops_per_thread / secs);
+}
+
 // NOLINTNEXTLINE
 TEST(RWLatchTest, BasicTest) {
   int num_threads = 100;
-  Counter counter{};
+  Counter<> counter{};
   counter.Add(5);
   std::vector<std::thread> threads;
   for (int tid = 0; tid < num_threads; tid++) {
@@ -57,4 +105,69 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, PerCoreBasicTest) {
+  int num_threads = 100;
+  Counter<PerCoreReaderWriterLatch> counter{};
+  counter.Add(5);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    if (tid % 2 == 0) {
+      threads.emplace_back([&counter]() { counter.Read(); });
+    } else {
+      threads.emplace_back([&counter]() { counter.Add(1); });
+    }
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  EXPECT_EQ(counter.Read(), 55);
+}
+
+// A writer waiting for the latch keeps new readers out, so it gets in even though readers never stop coming.
+// NOLINTNEXTLINE
+TEST(RWLatchTest, WriterPreferenceTest) {
+  ReaderWriterLatch latch;
+  std::atomic<bool> stop{false};
+  std::atomic<bool> written{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&latch, &stop] {
+      while (!stop) {
+        latch.RLock();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        latch.RUnlock();
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  std::thread writer([&latch, &written] {
+    latch.WLock();
+    written = true;
+    latch.WUnlock();
+  });
+  for (int i = 0; i < 1000 && !written; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(written);
+  stop = true;
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+// Throughput of the latches under read-heavy, mixed and write-heavy loads. Prints results only.
+// NOLINTNEXTLINE
+TEST(RWLatchTest, DISABLED_BenchmarkTest) {
+  const int ops_per_thread = 100000;
+  for (int num_threads : {1, 8}) {
+    for (int write_percent : {5, 50, 95}) {
+      RunLatchBenchmark<StdSharedMutex>("std::shared_mutex", num_threads, ops_per_thread, write_percent);
+      RunLatchBenchmark<ReaderWriterLatch>("rwlatch", num_threads, ops_per_thread, write_percent);
+      RunLatchBenchmark<PerCoreReaderWriterLatch>("per-core rwlatch", num_threads, ops_per_thread, write_percent);
+    }
+  }
+}
 }  // namespace bustub
@@ -10,11 +10,26 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/io_uring_async_io.h"
 
 namespace bustub {
 
@@ -24,13 +39,22 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    RemoveDataFiles();
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    RemoveDataFiles();
   };
+
+  // The extra data files of the tablespace tests.
+  static void RemoveDataFiles() {
+    for (int i = 1; i < 4; i++) {
+      remove(("test_" + std::to_string(i) + ".db").c_str());
+    }
+  }
 };
 
 // NOLINTNEXTLINE
@@ -72,6 +96,791 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReopenLogTest) {
+  char buf[32] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    char first[16] = "first";
+    dm.WriteLog(first, sizeof(first));
+    dm.ShutDown();
+  }
+  // The log is appended to, not overwritten, after a restart.
+  auto dm = DiskManager(db_file);
+  char second[16] = "second";
+  dm.WriteLog(second, sizeof(second));
+  EXPECT_TRUE(dm.ReadLog(buf, sizeof(buf), 0));
+  EXPECT_STREQ("first", buf);
+  EXPECT_STREQ("second", buf + 16);
+  EXPECT_FALSE(dm.ReadLog(buf, sizeof(buf), 32));
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeOffsetTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Past 4 GiB; the file is sparse, so this takes no space.
+  const page_id_t page_id = (1 << 20) + 1;
+  dm.WritePage(page_id, data);
+  dm.ReadPage(page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  // With a 32-bit offset, the write would have landed on page 1.
+  dm.ReadPage(1, buf);
+  EXPECT_EQ(buf[0], 0);
+  dm.ReadPage(page_id + 1, buf);
+  EXPECT_EQ(buf[0], 0);
+
+  dm.ShutDown();
+}
+
+/** DiskManager that serializes reads behind one latch, as a single shared file cursor would. */
+class SerializedDiskManager : public DiskManager {
+ public:
+  explicit SerializedDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    std::scoped_lock lock(latch_);
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+ private:
+  std::mutex latch_;
+};
+
+// Random page reads from a growing number of threads, with and without a latch around every read. Prints results
+// only; reads are served from the OS page cache, so they scale with the number of cores.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_ParallelReadBenchmarkTest) {
+  const std::string db_file("test.db");
+  const int num_pages = 4096;
+  const int reads_per_thread = 20000;
+  {
+    auto dm = DiskManager(db_file);
+    char data[PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    dm.ShutDown();
+  }
+
+  std::printf("[parallel read] %u hardware threads\n", std::thread::hardware_concurrency());
+  for (bool serialized : {true, false}) {
+    for (int num_threads : {1, 2, 4, 8}) {
+      DiskManager *dm = serialized ? new SerializedDiskManager(db_file) : new DiskManager(db_file);
+      std::atomic<int> num_errors{0};
+      std::vector<std::thread> threads;
+      const auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([dm, t, &num_errors] {
+          std::default_random_engine rng(t);
+          std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+          char buf[PAGE_SIZE];
+          for (int i = 0; i < reads_per_thread; i++) {
+            const page_id_t page_id = page_dist(rng);
+            dm->ReadPage(page_id, buf);
+            if (std::memcmp(buf, &page_id, sizeof(page_id)) != 0) {
+              num_errors++;
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      EXPECT_EQ(0, num_errors);
+      std::printf("[parallel read] %-10s %d threads: %.0f reads/s\n", serialized ? "serialized" : "pread", num_threads,
+                  num_threads * reads_per_thread / seconds);
+      dm->ShutDown();
+      delete dm;
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncIoTest) {
+  const std::string db_file("test.db");
+  const size_t queue_depth = 16;
+  auto dm = DiskManager(db_file);
+  // Whatever the system offers, and the synchronous fallback.
+  std::vector<std::unique_ptr<AsyncIo>> ios;
+  ios.push_back(dm.CreateAsyncIo(queue_depth));
+  ios.push_back(std::make_unique<AsyncIo>(&dm, queue_depth));
+
+  for (size_t round = 0; round < 2 * ios.size(); round++) {
+    AsyncIo *io = ios[round % ios.size()].get();
+    std::vector<char> buffers(queue_depth * PAGE_SIZE);
+    if (round >= ios.size()) {
+      // Registration is optional, and requests must work the same either way.
+      io->RegisterBuffers(buffers.data(), buffers.size());
+    }
+    std::vector<IoCompletion> completions;
+    for (size_t i = 0; i < queue_depth; i++) {
+      snprintf(&buffers[i * PAGE_SIZE], PAGE_SIZE, "round %zu page %zu", round, i);
+      io->QueueWrite(static_cast<page_id_t>(i), &buffers[i * PAGE_SIZE], i);
+    }
+    EXPECT_EQ(queue_depth, io->GetNumPending());
+    io->Submit();
+    io->Reap(&completions, queue_depth);
+    EXPECT_EQ(0, io->GetNumPending());
+    ASSERT_EQ(queue_depth, completions.size());
+    std::vector<bool> seen(queue_depth, false);
+    for (const IoCompletion &completion : completions) {
+      EXPECT_TRUE(completion.ok_);
+      seen[completion.tag_] = true;
+    }
+    EXPECT_EQ(std::vector<bool>(queue_depth, true), seen);
+
+    // Read everything back in reverse, the last page from past the end of the file.
+    std::fill(buffers.begin(), buffers.end(), 'x');
+    for (size_t i = 0; i < queue_depth; i++) {
+      io->QueueRead(static_cast<page_id_t>(queue_depth - i), &buffers[i * PAGE_SIZE], i);
+    }
+    io->Submit();
+    completions.clear();
+    while (io->GetNumPending() > 0) {
+      io->Reap(&completions, 1);
+    }
+    EXPECT_EQ(queue_depth, completions.size());
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buffers.begin(), buffers.begin() + PAGE_SIZE));
+    for (size_t i = 1; i < queue_depth; i++) {
+      EXPECT_EQ("round " + std::to_string(round) + " page " + std::to_string(queue_depth - i), &buffers[i * PAGE_SIZE]);
+    }
+    // Asynchronous writes are visible to the synchronous interface.
+    char buf[PAGE_SIZE];
+    dm.ReadPage(static_cast<page_id_t>(queue_depth - 1), buf);
+    EXPECT_EQ("round " + std::to_string(round) + " page " + std::to_string(queue_depth - 1), buf);
+  }
+  ios.clear();
+  dm.ShutDown();
+}
+
+// Random page reads from a single thread, one at a time and with dozens in flight. Prints results only; reads are
+// served from the OS page cache, so there is little latency for the queue to hide.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_AsyncReadBenchmarkTest) {
+  const std::string db_file("test.db");
+  const int num_pages = 4096;
+  const int num_reads = 40000;
+  auto dm = DiskManager(db_file);
+  {
+    char data[PAGE_SIZE] = {0};
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+  }
+
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+  std::vector<page_id_t> page_ids(num_reads);
+  for (auto &page_id : page_ids) {
+    page_id = page_dist(rng);
+  }
+  for (size_t queue_depth : {0, 1, 8, 32}) {
+    std::unique_ptr<AsyncIo> io = queue_depth == 0 ? nullptr : dm.CreateAsyncIo(queue_depth);
+    std::vector<char> buffers(std::max<size_t>(queue_depth, 1) * PAGE_SIZE);
+    std::vector<IoCompletion> completions;
+    int num_errors = 0;
+    const auto start = std::chrono::steady_clock::now();
+    if (io == nullptr) {
+      for (page_id_t page_id : page_ids) {
+        dm.ReadPage(page_id, buffers.data());
+        num_errors += std::memcmp(buffers.data(), &page_id, sizeof(page_id)) != 0 ? 1 : 0;
+      }
+    } else {
+      // Keep the queue full: refill a buffer as soon as its read has been checked.
+      std::vector<page_id_t> buffer_page_ids(queue_depth);
+      size_t next = 0;
+      for (; next < queue_depth; next++) {
+        buffer_page_ids[next] = page_ids[next];
+        io->QueueRead(page_ids[next], &buffers[next * PAGE_SIZE], next);
+      }
+      while (io->GetNumPending() > 0) {
+        io->Submit();
+        completions.clear();
+        io->Reap(&completions, 1);
+        for (const IoCompletion &completion : completions) {
+          char *buffer = &buffers[completion.tag_ * PAGE_SIZE];
+          page_id_t &page_id = buffer_page_ids[completion.tag_];
+          num_errors += std::memcmp(buffer, &page_id, sizeof(page_id)) != 0 ? 1 : 0;
+          if (next < page_ids.size()) {
+            page_id = page_ids[next++];
+            io->QueueRead(page_id, buffer, completion.tag_);
+          }
+        }
+      }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0, num_errors);
+    const char *name = io == nullptr                                     ? "ReadPage"
+                       : dynamic_cast<IoUringAsyncIo *>(io.get()) != nullptr ? "io_uring"
+                                                                             : "fallback";
+    std::printf("[async read] %-8s queue depth %2zu: %.0f reads/s\n", name, queue_depth, num_reads / seconds);
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PreallocationTest) {
+  const std::string db_file("test.db");
+  const size_t extent_size = 256 * PAGE_SIZE;
+  char data[PAGE_SIZE] = "page";
+  char buf[PAGE_SIZE];
+  struct stat stat_buf;
+  {
+    auto dm = DiskManager(db_file);
+    dm.SetExtentSize(extent_size);
+    dm.WritePage(0, data);
+    ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+    if (dm.GetExtentSize() == 0) {
+      std::printf("[preallocation] not supported by this file system\n");
+    } else {
+      // The first extent is there as a whole, but the file ends at the last page written; the rest reads as zeros.
+      EXPECT_EQ(PAGE_SIZE, stat_buf.st_size);
+      EXPECT_GE(stat_buf.st_blocks * 512, extent_size);
+      dm.ReadPage(1, buf);
+      EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf, buf + PAGE_SIZE));
+      // A write far ahead preallocates its own extent only, not everything before it.
+      dm.WritePage(100 * 256, data);
+      ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+      EXPECT_EQ(100 * extent_size + PAGE_SIZE, stat_buf.st_size);
+      EXPECT_LT(stat_buf.st_blocks * 512, 4 * extent_size);
+    }
+    dm.WritePage(2, data);
+    // A disk manager opened on the file after a crash, without ShutDown, does not see the preallocated pages either.
+    DiskManager reopened(db_file);
+    EXPECT_EQ(100 * 256 + 1, reopened.GetNumPages());
+    reopened.ShutDown();
+    dm.ShutDown();
+  }
+  ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+  EXPECT_EQ(100 * extent_size + PAGE_SIZE, stat_buf.st_size);
+
+  // Without preallocation the file grows a page at a time.
+  remove(db_file.c_str());
+  auto dm = DiskManager(db_file);
+  dm.SetExtentSize(0);
+  dm.WritePage(0, data);
+  dm.WritePage(1, data);
+  ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+  EXPECT_EQ(2 * PAGE_SIZE, stat_buf.st_size);
+  dm.ReadPage(1, buf);
+  EXPECT_STREQ("page", buf);
+  dm.ShutDown();
+}
+
+// A bulk load: pages written in id order, synced every so often as a checkpoint would, with the file growing a page
+// at a time and an extent at a time. Prints results only.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_PreallocationBenchmarkTest) {
+  const std::string db_file("test.db");
+  const int num_pages = 16384;
+  const int pages_per_sync = 256;
+  char data[PAGE_SIZE] = {0};
+  for (DurabilityPolicy policy : {DurabilityPolicy::SYNC_LOG, DurabilityPolicy::SYNC_ALL}) {
+    // Syncing every page is slow; load less.
+    const int num_loaded = policy == DurabilityPolicy::SYNC_ALL ? num_pages / 8 : num_pages;
+    for (size_t extent_size : {size_t{0}, DB_FILE_EXTENT_SIZE}) {
+      remove(db_file.c_str());
+      auto dm = DiskManager(db_file);
+      dm.SetDurabilityPolicy(policy);
+      dm.SetExtentSize(extent_size);
+      const auto start = std::chrono::steady_clock::now();
+      for (page_id_t page_id = 0; page_id < num_loaded; page_id++) {
+        std::memcpy(data, &page_id, sizeof(page_id));
+        dm.WritePage(page_id, data);
+        if ((page_id + 1) % pages_per_sync == 0) {
+          dm.Sync();
+        }
+      }
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::printf("[preallocation] %-20s, %2zu MiB extents: %.0f pages/s\n",
+                  policy == DurabilityPolicy::SYNC_ALL ? "sync every page" : "sync every 256 pages",
+                  dm.GetExtentSize() / (1024 * 1024), num_loaded / seconds);
+      dm.ShutDown();
+    }
+  }
+}
+
+/** DiskManager that counts the calls to Sync. */
+class SyncCountingDiskManager : public DiskManager {
+ public:
+  explicit SyncCountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void Sync() override {
+    num_syncs_++;
+    DiskManager::Sync();
+  }
+
+  int num_syncs_{0};
+};
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DurabilityPolicyTest) {
+  const std::string db_file("test.db");
+  SyncCountingDiskManager dm(db_file);
+  char data[PAGE_SIZE] = {0};
+  std::vector<const char *> run(4, data);
+  std::pair<page_id_t, const char *> batch[] = {{0, data}, {1, data}};
+
+  // Pages are synced when asked to, and only then.
+  EXPECT_EQ(DurabilityPolicy::SYNC_LOG, dm.GetDurabilityPolicy());
+  dm.WritePage(0, data);
+  dm.WritePages(0, run.data(), run.size());
+  dm.WritePageBatch(batch, 2, false);
+  EXPECT_EQ(0, dm.num_syncs_);
+  dm.WritePageBatch(batch, 2, true);
+  EXPECT_EQ(1, dm.num_syncs_);
+
+  // Every write is synced.
+  dm.SetDurabilityPolicy(DurabilityPolicy::SYNC_ALL);
+  dm.num_syncs_ = 0;
+  dm.WritePage(0, data);
+  dm.WritePages(0, run.data(), run.size());
+  EXPECT_EQ(2, dm.num_syncs_);
+
+  // Asynchronous writes as well, by the time they are reaped; the system's interface may sync several at once.
+  for (DurabilityPolicy policy : {DurabilityPolicy::SYNC_LOG, DurabilityPolicy::SYNC_ALL}) {
+    dm.SetDurabilityPolicy(policy);
+    dm.num_syncs_ = 0;
+    std::unique_ptr<AsyncIo> io = dm.CreateAsyncIo(run.size());
+    for (size_t i = 0; i < run.size(); i++) {
+      io->QueueWrite(static_cast<page_id_t>(i), data, i);
+    }
+    io->Submit();
+    std::vector<IoCompletion> completions;
+    io->Reap(&completions, run.size());
+    EXPECT_EQ(run.size(), completions.size());
+    if (policy == DurabilityPolicy::SYNC_ALL) {
+      EXPECT_LE(1, dm.num_syncs_);
+    } else {
+      EXPECT_EQ(0, dm.num_syncs_);
+    }
+  }
+
+  // Whatever the policy, everything written reads back.
+  char log_buffers[2][16] = {};
+  for (DurabilityPolicy policy : {DurabilityPolicy::NO_SYNC, DurabilityPolicy::SYNC_LOG, DurabilityPolicy::SYNC_ALL}) {
+    dm.SetDurabilityPolicy(policy);
+    snprintf(data, PAGE_SIZE, "policy %d", static_cast<int>(policy));
+    dm.WritePage(7, data);
+    // WriteLog wants the log manager's two buffers used in turn.
+    char *log_data = log_buffers[static_cast<int>(policy) % 2];
+    snprintf(log_data, sizeof(log_buffers[0]), "log %d", static_cast<int>(policy));
+    dm.WriteLog(log_data, sizeof(log_buffers[0]));
+    dm.Sync();
+    char buf[PAGE_SIZE];
+    dm.ReadPage(7, buf);
+    EXPECT_STREQ(data, buf);
+    dm.ReadLog(buf, sizeof(log_buffers[0]), static_cast<int>(policy) * static_cast<int>(sizeof(log_buffers[0])));
+    EXPECT_STREQ(log_data, buf);
+  }
+  dm.ShutDown();
+}
+
+// Commit and page write throughput under each durability policy. A commit appends a small log record; with group
+// commit, several commits share one log write and so one sync. Prints results only.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_DurabilityPolicyBenchmarkTest) {
+  const std::string db_file("test.db");
+  const int num_commits = 256;
+  const int record_size = 128;
+  const int num_pages = 256;
+  const char *names[] = {"no sync", "sync log", "sync all"};
+  // WriteLog wants the log manager's two buffers used in turn.
+  std::vector<char> log_buffers[2] = {std::vector<char>(LOG_BUFFER_SIZE, 'l'), std::vector<char>(LOG_BUFFER_SIZE, 'l')};
+  char data[PAGE_SIZE] = {0};
+
+  for (DurabilityPolicy policy : {DurabilityPolicy::NO_SYNC, DurabilityPolicy::SYNC_LOG, DurabilityPolicy::SYNC_ALL}) {
+    remove(db_file.c_str());
+    remove("test.log");
+    auto dm = DiskManager(db_file);
+    dm.SetDurabilityPolicy(policy);
+    std::printf("[durability] %-8s:", names[static_cast<int>(policy)]);
+    for (int group_size : {1, 32}) {
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_commits / group_size; i++) {
+        dm.WriteLog(log_buffers[i % 2].data(), group_size * record_size);
+      }
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::printf(" %.0f commits/s in groups of %d,", num_commits / seconds, group_size);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      dm.WritePage(page_id, data);
+    }
+    dm.Sync();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf(" %.0f page writes/s\n", num_pages / seconds);
+    dm.ShutDown();
+  }
+}
+
+/** DiskManager that counts the runs a batch is split into. */
+class RunCountingDiskManager : public DiskManager {
+ public:
+  explicit RunCountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) override {
+    num_runs_++;
+    DiskManager::WritePages(first_page_id, pages_data, num_pages);
+  }
+
+  void ReadPages(page_id_t first_page_id, char *const *pages_data, size_t num_pages) override {
+    num_runs_++;
+    DiskManager::ReadPages(first_page_id, pages_data, num_pages);
+  }
+
+  int num_runs_{0};
+};
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageBatchTest) {
+  const std::string db_file("test.db");
+  RunCountingDiskManager dm(db_file);
+  const std::vector<page_id_t> page_ids = {1, 2, 3, 7, 8, 5};
+  std::vector<char> buffers(page_ids.size() * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> write_batch;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    snprintf(&buffers[i * PAGE_SIZE], PAGE_SIZE, "page %d", page_ids[i]);
+    write_batch.emplace_back(page_ids[i], &buffers[i * PAGE_SIZE]);
+  }
+  // Three runs: 1-3, 7-8 and 5.
+  dm.WritePageBatch(write_batch.data(), write_batch.size(), true);
+  EXPECT_EQ(3, dm.num_runs_);
+  EXPECT_EQ(6, dm.GetNumWrites());
+
+  // Read back in a different order, with the run 8-10 ending past the end of the file and page 0 never written.
+  const std::vector<page_id_t> read_ids = {0, 1, 2, 3, 8, 9, 10, 7, 5};
+  std::vector<char> read_buffers(read_ids.size() * PAGE_SIZE, 'x');
+  std::vector<std::pair<page_id_t, char *>> read_batch;
+  for (size_t i = 0; i < read_ids.size(); i++) {
+    read_batch.emplace_back(read_ids[i], &read_buffers[i * PAGE_SIZE]);
+  }
+  dm.num_runs_ = 0;
+  dm.ReadPageBatch(read_batch.data(), read_batch.size());
+  EXPECT_EQ(4, dm.num_runs_);
+  const std::vector<char> zeros(PAGE_SIZE, 0);
+  for (size_t i = 0; i < read_ids.size(); i++) {
+    const char *data = read_batch[i].second;
+    if (read_ids[i] == 0 || read_ids[i] > 8) {
+      EXPECT_EQ(zeros, std::vector<char>(data, data + PAGE_SIZE)) << "page " << read_ids[i];
+    } else {
+      EXPECT_EQ("page " + std::to_string(read_ids[i]), data);
+    }
+  }
+  dm.ShutDown();
+}
+
+// Writes and reads the same pages in runs of 1 to 256 consecutive pages, one vectored call per run. Prints results
+// only; the file stays in the OS page cache, so this measures the cost of the system calls.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_PageBatchBenchmarkTest) {
+  const std::string db_file("test.db");
+  const size_t num_pages = 8192;
+  auto dm = DiskManager(db_file);
+  std::vector<char> buffers(num_pages * PAGE_SIZE);
+  for (size_t run_length : {1, 4, 16, 64, 256}) {
+    std::vector<std::pair<page_id_t, const char *>> write_batch;
+    std::vector<std::pair<page_id_t, char *>> read_batch;
+    for (size_t i = 0; i < num_pages; i++) {
+      write_batch.emplace_back(static_cast<page_id_t>(i), &buffers[i * PAGE_SIZE]);
+      read_batch.emplace_back(static_cast<page_id_t>(i), &buffers[i * PAGE_SIZE]);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < num_pages; begin += run_length) {
+      dm.WritePageBatch(&write_batch[begin], run_length, false);
+    }
+    const double write_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < num_pages; begin += run_length) {
+      dm.ReadPageBatch(&read_batch[begin], run_length);
+    }
+    const double read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[page batch] runs of %3zu pages: writes %.0f pages/s, reads %.0f pages/s\n", run_length,
+                num_pages / write_seconds, num_pages / read_seconds);
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, TablespaceTest) {
+  const std::vector<std::string> db_files = {"test.db", "test_1.db", "test_2.db"};
+  const size_t stripe_pages = 4;
+  const size_t num_pages = 26;
+  std::vector<char> buffers(num_pages * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> write_batch;
+  for (size_t i = 0; i < num_pages; i++) {
+    snprintf(&buffers[i * PAGE_SIZE], PAGE_SIZE, "page %zu", i);
+    write_batch.emplace_back(static_cast<page_id_t>(i), &buffers[i * PAGE_SIZE]);
+  }
+  {
+    DiskManager dm(db_files, stripe_pages);
+    dm.SetExtentSize(0);
+    // Each file's share of a batch is written, and synced, on its own I/O queue.
+    dm.SetDurabilityPolicy(DurabilityPolicy::SYNC_ALL);
+    EXPECT_EQ(3, dm.GetNumDataFiles());
+    EXPECT_EQ(0, dm.GetDataFile(3));
+    EXPECT_EQ(1, dm.GetDataFile(4));
+    EXPECT_EQ(2, dm.GetDataFile(11));
+    EXPECT_EQ(0, dm.GetDataFile(12));
+    // One batch that every file takes part of, and a page written on its own.
+    dm.WritePageBatch(write_batch.data(), num_pages - 1, true);
+    dm.WritePage(num_pages - 1, &buffers[(num_pages - 1) * PAGE_SIZE]);
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+    dm.ShutDown();
+  }
+  // Stripes 0, 3 and 6 (pages 24-25) in the first file, 1 and 4 in the second, 2 and 5 in the third.
+  struct stat stat_buf;
+  const std::vector<size_t> file_pages = {10, 8, 8};
+  for (size_t i = 0; i < db_files.size(); i++) {
+    ASSERT_EQ(0, stat(db_files[i].c_str(), &stat_buf));
+    EXPECT_EQ(file_pages[i] * PAGE_SIZE, stat_buf.st_size) << db_files[i];
+  }
+  char buf[PAGE_SIZE];
+  const int fd = open(db_files[1].c_str(), O_RDONLY);
+  ASSERT_EQ(PAGE_SIZE, pread(fd, buf, PAGE_SIZE, 5 * PAGE_SIZE));
+  EXPECT_STREQ("page 17", buf);
+  close(fd);
+
+  // Reopened with the same layout, it finds where the pages end, and every page reads back, whether on its own, in a
+  // batch or asynchronously.
+  DiskManager dm(db_files, stripe_pages);
+  EXPECT_EQ(num_pages, dm.GetNumPages());
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(static_cast<page_id_t>(i), buf);
+    EXPECT_EQ("page " + std::to_string(i), buf);
+  }
+  std::vector<char> read_buffers((num_pages + 2) * PAGE_SIZE, 'x');
+  std::vector<char *> read_pages;
+  for (size_t i = 0; i < num_pages + 2; i++) {
+    read_pages.push_back(&read_buffers[i * PAGE_SIZE]);
+  }
+  dm.ReadPages(0, read_pages.data(), num_pages + 2);
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ("page " + std::to_string(i), read_pages[i]);
+  }
+  // The two pages past the end of the last stripe read as zeros.
+  const std::vector<char> zeros(PAGE_SIZE, 0);
+  EXPECT_EQ(zeros, std::vector<char>(read_pages[num_pages], read_pages[num_pages] + PAGE_SIZE));
+  EXPECT_EQ(zeros, std::vector<char>(read_pages[num_pages + 1], read_pages[num_pages + 1] + PAGE_SIZE));
+  std::unique_ptr<AsyncIo> io = dm.CreateAsyncIo(num_pages);
+  std::fill(read_buffers.begin(), read_buffers.end(), 'x');
+  for (size_t i = 0; i < num_pages; i++) {
+    io->QueueRead(static_cast<page_id_t>(i), read_pages[i], i);
+  }
+  io->Submit();
+  std::vector<IoCompletion> completions;
+  io->Reap(&completions, num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ("page " + std::to_string(i), read_pages[i]);
+  }
+  io.reset();
+  dm.ShutDown();
+}
+
+// Writes pages in batches and syncs after each, as a checkpoint would, with the pages in one file and striped over
+// four. Prints results only; the files share one device here, so this mostly shows what the I/O queues cost.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_TablespaceBenchmarkTest) {
+  const size_t num_pages = 8192;
+  const size_t batch_pages = 512;
+  std::vector<char> buffers(batch_pages * PAGE_SIZE);
+  for (size_t num_files : {1, 4}) {
+    std::vector<std::string> db_files = {"test.db"};
+    for (size_t i = 1; i < num_files; i++) {
+      db_files.push_back("test_" + std::to_string(i) + ".db");
+    }
+    remove("test.db");
+    RemoveDataFiles();
+    DiskManager dm(db_files, DATA_FILE_STRIPE_PAGES);
+    std::vector<std::pair<page_id_t, const char *>> batch(batch_pages);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < num_pages; begin += batch_pages) {
+      for (size_t i = 0; i < batch_pages; i++) {
+        batch[i] = {static_cast<page_id_t>(begin + i), &buffers[i * PAGE_SIZE]};
+      }
+      dm.WritePageBatch(batch.data(), batch_pages, false);
+      dm.Sync();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[tablespace] %zu data file(s): %.0f pages/s\n", num_files, num_pages / seconds);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MappedPagesTest) {
+  const std::string db_file("test.db");
+  DiskManager dm(db_file);
+  char data[PAGE_SIZE] = "page 1";
+  dm.WritePage(1, data);
+  std::unique_ptr<MappedPages> mapped_pages = dm.MapPages();
+  const char *page = mapped_pages->GetPage(1);
+  EXPECT_STREQ("page 1", page);
+  // Written after the mapping was made, in place.
+  snprintf(data, PAGE_SIZE, "page 1 again");
+  dm.WritePage(1, data);
+  EXPECT_STREQ("page 1 again", page);
+  // Never written pages read as zeros, whether inside the file or past its end.
+  const std::vector<char> zeros(PAGE_SIZE, 0);
+  EXPECT_EQ(zeros, std::vector<char>(mapped_pages->GetPage(0), mapped_pages->GetPage(0) + PAGE_SIZE));
+  EXPECT_EQ(zeros, std::vector<char>(mapped_pages->GetPage(2), mapped_pages->GetPage(2) + PAGE_SIZE));
+
+  // A page far past the first mapping gets the file mapped again, while what was handed out before stays valid.
+  const auto far_page_id = static_cast<page_id_t>(4 * DB_FILE_EXTENT_SIZE / PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "page %d", far_page_id);
+  dm.WritePage(far_page_id, data);
+  EXPECT_STREQ(data, mapped_pages->GetPage(far_page_id));
+  EXPECT_STREQ("page 1 again", page);
+  EXPECT_STREQ("page 1 again", mapped_pages->GetPage(1));
+  mapped_pages.reset();
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  const std::string db_file("test.db");
+  const size_t queue_depth = 8;
+  alignas(DIRECT_IO_ALIGNMENT) char aligned[PAGE_SIZE];
+  // One byte off an aligned address, which direct I/O cannot use as it is.
+  std::vector<char> unaligned_storage(PAGE_SIZE + DIRECT_IO_ALIGNMENT + 1);
+  char *unaligned = unaligned_storage.data() + 1;
+  if (reinterpret_cast<uintptr_t>(unaligned) % DIRECT_IO_ALIGNMENT == 0) {
+    unaligned++;
+  }
+  {
+    auto dm = DiskManager(db_file, true);
+    if (!dm.IsDirectIo()) {
+      std::printf("[direct io] not supported by this file system, testing the fallback\n");
+    }
+    std::memset(aligned, 0, PAGE_SIZE);
+    std::strncpy(aligned, "aligned", PAGE_SIZE);
+    dm.WritePage(0, aligned);
+    std::memset(unaligned, 0, PAGE_SIZE);
+    std::strncpy(unaligned, "unaligned", PAGE_SIZE);
+    dm.WritePage(1, unaligned);
+
+    dm.ReadPage(1, aligned);
+    EXPECT_STREQ("unaligned", aligned);
+    dm.ReadPage(0, unaligned);
+    EXPECT_STREQ("aligned", unaligned);
+    dm.ReadPage(2, unaligned);  // past the end of the file
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(unaligned, unaligned + PAGE_SIZE));
+
+    // Runs, and asynchronous requests on unaligned buffers.
+    std::vector<char> buffers(queue_depth * PAGE_SIZE + 1);
+    std::vector<char *> run(queue_depth);
+    for (size_t i = 0; i < queue_depth; i++) {
+      run[i] = &buffers[i * PAGE_SIZE + 1];
+      snprintf(run[i], PAGE_SIZE, "run page %zu", i);
+    }
+    dm.WritePages(2, run.data(), queue_depth);
+    std::unique_ptr<AsyncIo> io = dm.CreateAsyncIo(queue_depth);
+    for (size_t i = 0; i < queue_depth; i++) {
+      io->QueueRead(static_cast<page_id_t>(2 + queue_depth - 1 - i), run[i], i);
+    }
+    io->Submit();
+    std::vector<IoCompletion> completions;
+    while (io->GetNumPending() > 0) {
+      io->Reap(&completions, 1);
+    }
+    EXPECT_EQ(queue_depth, completions.size());
+    for (size_t i = 0; i < queue_depth; i++) {
+      EXPECT_EQ("run page " + std::to_string(queue_depth - 1 - i), run[i]);
+    }
+    io.reset();
+    dm.ShutDown();
+  }
+
+  // The file reads back the same without direct I/O.
+  auto dm = DiskManager(db_file);
+  dm.ReadPage(0, aligned);
+  EXPECT_STREQ("aligned", aligned);
+  dm.ReadPage(1, aligned);
+  EXPECT_STREQ("unaligned", aligned);
+  dm.ReadPage(2 + queue_depth - 1, aligned);
+  EXPECT_EQ("run page " + std::to_string(queue_depth - 1), aligned);
+  dm.ShutDown();
+}
+
+/** @return how many bytes of a file the OS page cache holds */
+static size_t CachedBytes(const std::string &file_name) {
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat stat_buf;
+  if (fd < 0 || fstat(fd, &stat_buf) != 0 || stat_buf.st_size == 0) {
+    return 0;
+  }
+  const auto size = static_cast<size_t>(stat_buf.st_size);
+  void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  const auto os_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  std::vector<unsigned char> resident((size + os_page_size - 1) / os_page_size);
+  size_t cached = 0;
+  if (map != MAP_FAILED && mincore(map, size, resident.data()) == 0) {
+    for (unsigned char page : resident) {
+      cached += (page & 1) != 0 ? os_page_size : 0;
+    }
+  }
+  if (map != MAP_FAILED) {
+    munmap(map, size);
+  }
+  close(fd);
+  return cached;
+}
+
+// Writes a file and reads it back at random, with and without direct I/O, and reports how much of it ends up in the
+// OS page cache: a second copy of whatever the buffer pool holds. Buffered reads start from a dropped cache, so both
+// modes read from the device. Prints results only.
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DISABLED_DirectIoBenchmarkTest) {
+  const std::string db_file("test.db");
+  const int num_pages = 4096;
+  const int num_reads = 4096;
+  alignas(DIRECT_IO_ALIGNMENT) char data[PAGE_SIZE] = {0};
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+
+  for (bool direct_io : {false, true}) {
+    remove(db_file.c_str());
+    auto dm = DiskManager(db_file, direct_io);
+    auto start = std::chrono::steady_clock::now();
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memcpy(data, &page_id, sizeof(page_id));
+      dm.WritePage(page_id, data);
+    }
+    const double write_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Write back and drop whatever the buffered writes left in the page cache.
+    const int fd = open(db_file.c_str(), O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    int num_errors = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_reads; i++) {
+      const page_id_t page_id = page_dist(rng);
+      dm.ReadPage(page_id, data);
+      num_errors += std::memcmp(data, &page_id, sizeof(page_id)) != 0 ? 1 : 0;
+    }
+    const double read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(0, num_errors);
+    const double mib = 1024.0 * 1024.0;
+    std::printf("[direct io] %-8s: writes %.1f MiB/s, random reads %.0f pages/s, page cache holds %.1f of %.1f MiB\n",
+                dm.IsDirectIo() ? "direct" : "buffered", num_pages * PAGE_SIZE / mib / write_seconds,
+                num_reads / read_seconds, CachedBytes(db_file) / mib, num_pages * PAGE_SIZE / mib);
+    dm.ShutDown();
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
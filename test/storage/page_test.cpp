@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_test.cpp
+//
+// Identification: test/storage/page_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+namespace {
+
+/** Number of sorted keys in the fake root page. */
+constexpr int NUM_KEYS = 500;
+
+/** Fill a page with NUM_KEYS sorted keys, each equal to base plus twice its index. */
+void FillRoot(Page *page, int32_t base) {
+  auto *keys = reinterpret_cast<int32_t *>(page->GetData());
+  for (int i = 0; i < NUM_KEYS; i++) {
+    keys[i] = base + 2 * i;
+  }
+}
+
+/** Look up the child index of a key in the fake root page, the way an internal node search would. */
+int SearchRoot(Page *page, int32_t key) {
+  const auto *keys = reinterpret_cast<const int32_t *>(page->GetData());
+  return static_cast<int>(std::upper_bound(keys, keys + NUM_KEYS, key) - keys);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PageTest, OptimisticReadTest) {
+  Page page;
+  FillRoot(&page, 0);
+
+  std::atomic<bool> stop{false};
+  std::thread writer([&page, &stop] {
+    for (int32_t base = 1; !stop; base++) {
+      page.WLatch();
+      FillRoot(&page, base);
+      page.WUnlatch();
+    }
+  });
+
+  // A validated read never sees a half-written page: the first and the last key always come from the same write.
+  const auto *keys = reinterpret_cast<const int32_t *>(page.GetData());
+  int validated = 0;
+  for (int i = 0; i < 100000; i++) {
+    uint64_t version = page.ROptimisticLatch();
+    int32_t first = keys[0];
+    int32_t last = keys[NUM_KEYS - 1];
+    if (page.ROptimisticValidate(version)) {
+      EXPECT_EQ(first + 2 * (NUM_KEYS - 1), last);
+      validated++;
+    }
+  }
+  stop = true;
+  writer.join();
+
+  // Without a writer, every optimistic read validates.
+  uint64_t version = page.ROptimisticLatch();
+  EXPECT_EQ(0U, version % 2);
+  EXPECT_TRUE(page.ROptimisticValidate(version));
+  page.WLatch();
+  page.WUnlatch();
+  EXPECT_FALSE(page.ROptimisticValidate(version));
+  EXPECT_GT(validated, 0);
+}
+
+// Throughput of root-page lookups by 32 threads, under the read latch and optimistically. Prints results only.
+// NOLINTNEXTLINE
+TEST(PageTest, DISABLED_RootReadBenchmarkTest) {
+  const int num_threads = 32;
+  const int lookups_per_thread = 50000;
+  Page root;
+  FillRoot(&root, 0);
+
+  for (bool optimistic : {false, true}) {
+    std::atomic<int> retries{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&root, &retries, optimistic, tid] {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<int32_t> dist(0, 2 * NUM_KEYS);
+        int64_t sum = 0;
+        for (int i = 0; i < lookups_per_thread; i++) {
+          int32_t key = dist(rng);
+          if (!optimistic) {
+            root.RLatch();
+            sum += SearchRoot(&root, key);
+            root.RUnlatch();
+            continue;
+          }
+          while (true) {
+            uint64_t version = root.ROptimisticLatch();
+            int child = SearchRoot(&root, key);
+            if (root.ROptimisticValidate(version)) {
+              sum += child;
+              break;
+            }
+            retries++;
+          }
+        }
+        EXPECT_GE(sum, 0);
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[root read] threads=%d %-10s %10.0f lookups/s, %d retries\n", num_threads,
+           optimistic ? "optimistic" : "rlatch", num_threads * lookups_per_thread / secs, retries.load());
+  }
+}
+
+}  // namespace bustub
@@ -11,9 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -21,6 +26,7 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +77,374 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+/** A disk manager whose reads take a while, and which counts them. */
+class SlowReadDiskManager : public DiskManager {
+ public:
+  explicit SlowReadDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (slow_) {
+      std::this_thread::sleep_for(std::chrono::microseconds(300));
+    }
+    num_reads_++;
+    DiskManager::ReadPage(page_id, page_data);
+  }
+
+  /** Read-ahead reads through ReadPage as well. */
+  std::unique_ptr<AsyncIo> CreateAsyncIo(size_t queue_depth) override {
+    return std::make_unique<AsyncIo>(this, queue_depth);
+  }
+
+  std::atomic<bool> slow_{false};
+  std::atomic<int> num_reads_{0};
+};
+
+/** Spin for a while, standing in for the work a query does on each page of a scan. */
+static void ProcessPage() {
+  auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(300);
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+/** Fill a new table heap with num_tuples tuples on disk, and return its first page. */
+static page_id_t CreateScanTable(DiskManager *disk_manager, LockManager *lock_manager, LogManager *log_manager,
+                                 Transaction *transaction, int num_tuples) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 200}}};
+  std::vector<Value> values{ValueFactory::GetBigIntValue(42), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+  Tuple tuple{values, &schema};
+  BufferPoolManagerInstance bpm(16, disk_manager);
+  TableHeap table(&bpm, lock_manager, log_manager, transaction);
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    EXPECT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+  }
+  bpm.FlushAllPages();
+  return table.GetFirstPageId();
+}
+
+// A cold full scan sees every tuple whatever the read-ahead window, and a scan that stops early cancels its read-ahead.
+// NOLINTNEXTLINE
+TEST(TupleTest, ReadAheadScanTest) {
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new SlowReadDiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  const int num_tuples = 4000;
+  const page_id_t first_page_id = CreateScanTable(disk_manager, lock_manager, log_manager, transaction, num_tuples);
+  disk_manager->slow_ = true;
+
+  for (size_t read_ahead_pages : {0, 8, 32}) {
+    BufferPoolManagerInstance bpm(64, disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+    table.SetReadAheadPages(read_ahead_pages);
+    int count = 0;
+    for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+      count++;
+    }
+    EXPECT_EQ(num_tuples, count) << read_ahead_pages;
+  }
+
+  // Far fewer pages are read than the table holds.
+  {
+    BufferPoolManagerInstance bpm(64, disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+    table.SetReadAheadPages(8);
+    disk_manager->num_reads_ = 0;
+    {
+      auto itr = table.Begin(transaction);
+      for (int i = 0; i < 200; i++) {
+        ++itr;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LT(disk_manager->num_reads_, 30);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// A cold full scan with and without read-ahead, which should overlap the reads of upcoming pages with the work done
+// on the current one. Prints results only.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_ReadAheadScanBenchmarkTest) {
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new SlowReadDiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  const page_id_t first_page_id = CreateScanTable(disk_manager, lock_manager, log_manager, transaction, 4000);
+  disk_manager->slow_ = true;
+
+  for (size_t read_ahead_pages : {0, 8, 32}) {
+    BufferPoolManagerInstance bpm(64, disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+    table.SetReadAheadPages(read_ahead_pages);
+
+    page_id_t last_page_id = INVALID_PAGE_ID;
+    auto start = std::chrono::steady_clock::now();
+    for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+      if (itr->GetRid().GetPageId() != last_page_id) {
+        last_page_id = itr->GetRid().GetPageId();
+        ProcessPage();
+      }
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[read-ahead scan] read_ahead_pages=%2zu  %8.2f ms\n", read_ahead_pages, elapsed);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// A full scan of a table several times larger than the buffer pool must not flush the pool's other pages.
+// NOLINTNEXTLINE
+TEST(TupleTest, RingScanTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 200}}};
+  std::vector<Value> values{ValueFactory::GetBigIntValue(42), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+  Tuple tuple{values, &schema};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new SlowReadDiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  page_id_t first_page_id;
+  std::vector<page_id_t> hot_page_ids;
+  const int num_tuples = 4000;
+  {
+    BufferPoolManagerInstance bpm(16, disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, transaction);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+    }
+    EXPECT_GT(table.GetNumPages(), 64);
+    for (int i = 0; i < 8; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      bpm.UnpinPage(page_id, true);
+      hot_page_ids.push_back(page_id);
+    }
+    bpm.FlushAllPages();
+  }
+
+  for (size_t read_ahead_pages : {0, 8}) {
+    BufferPoolManagerInstance bpm(64, disk_manager);
+    for (page_id_t page_id : hot_page_ids) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      bpm.UnpinPage(page_id, false);
+    }
+
+    // The table is opened, so its size is unknown up front: the scan switches to a ring once it has seen enough.
+    TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+    table.SetReadAheadPages(read_ahead_pages);
+    int count = 0;
+    for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+      count++;
+    }
+    EXPECT_EQ(num_tuples, count);
+
+    int num_reads = disk_manager->num_reads_;
+    for (page_id_t page_id : hot_page_ids) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      bpm.UnpinPage(page_id, false);
+    }
+    EXPECT_EQ(num_reads, disk_manager->num_reads_);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// A mapped scan sees the same tuples as a scan through the buffer pool, without reading a page through either.
+// NOLINTNEXTLINE
+TEST(TupleTest, MappedScanTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new SlowReadDiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  const int num_tuples = 4000;
+  BufferPoolManagerInstance bpm(16, disk_manager);
+  TableHeap table(&bpm, lock_manager, log_manager, transaction);
+  for (int i = 0; i < num_tuples; i++) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(Tuple{values, &schema}, &rid, transaction));
+  }
+  bpm.FlushAllPages();
+
+  std::vector<std::pair<RID, int64_t>> expected;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+    expected.emplace_back(itr->GetRid(), itr->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  ASSERT_EQ(num_tuples, expected.size());
+
+  std::unique_ptr<MappedPages> mapped_pages = disk_manager->MapPages();
+  table.SetMappedPages(mapped_pages.get());
+  disk_manager->num_reads_ = 0;
+  std::vector<std::pair<RID, int64_t>> scanned;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+    scanned.emplace_back(itr->GetRid(), itr->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  EXPECT_EQ(expected, scanned);
+  EXPECT_EQ(0, disk_manager->num_reads_);
+
+  // Writes still go through the buffer pool, and show up in the mapping once they are written back.
+  RID rid;
+  std::vector<Value> values{ValueFactory::GetBigIntValue(-1), ValueFactory::GetVarcharValue("y")};
+  ASSERT_TRUE(table.InsertTuple(Tuple{values, &schema}, &rid, transaction));
+  bpm.FlushAllPages();
+  int count = 0;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples + 1, count);
+
+  table.SetMappedPages(nullptr);
+  mapped_pages.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// A mapped scan of a table heap that was not flushed reads the pages whose latest changes have not reached the disk
+// from the buffer pool, rather than missing those changes.
+// NOLINTNEXTLINE
+TEST(TupleTest, MappedScanUnflushedTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  const int num_tuples = 4000;
+  BufferPoolManagerInstance bpm(16, disk_manager);
+  TableHeap table(&bpm, lock_manager, log_manager, transaction);
+  for (int i = 0; i < num_tuples; i++) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+    RID rid;
+    ASSERT_TRUE(table.InsertTuple(Tuple{values, &schema}, &rid, transaction));
+  }
+
+  // The first pages have been evicted and written back for good. The last ones are still dirty in the buffer pool, and
+  // may have been written back before their last inserts.
+  std::unique_ptr<MappedPages> mapped_pages = disk_manager->MapPages();
+  table.SetMappedPages(mapped_pages.get());
+  std::vector<int64_t> scanned;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+    scanned.push_back(itr->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  ASSERT_EQ(num_tuples, scanned.size());
+  for (int i = 0; i < num_tuples; i++) {
+    EXPECT_EQ(i, scanned[i]);
+  }
+
+  // Nothing of a table heap too small to be evicted is on disk.
+  TableHeap small_table(&bpm, lock_manager, log_manager, transaction);
+  for (int i = 0; i < 10; i++) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(i), ValueFactory::GetVarcharValue("y")};
+    RID rid;
+    ASSERT_TRUE(small_table.InsertTuple(Tuple{values, &schema}, &rid, transaction));
+  }
+  small_table.SetMappedPages(mapped_pages.get());
+  int count = 0;
+  for (auto itr = small_table.Begin(transaction); itr != small_table.End(); ++itr) {
+    EXPECT_EQ(count++, itr->GetValue(&schema, 0).GetAs<int64_t>());
+  }
+  EXPECT_EQ(10, count);
+
+  small_table.SetMappedPages(nullptr);
+  table.SetMappedPages(nullptr);
+  mapped_pages.reset();
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// Full scans of the same table through buffer pools a fraction of its size to twice its size, and of a mapping of its
+// file. Each scan runs twice and the second is timed, so the file is in the OS page cache and the larger pools hold
+// the whole table. Prints results only.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_MappedScanBenchmarkTest) {
+  Schema schema{std::vector<Column>{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 200}}};
+  std::vector<Value> values{ValueFactory::GetBigIntValue(42), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+  Tuple tuple{values, &schema};
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  page_id_t first_page_id;
+  size_t num_pages;
+  const int num_tuples = 10000;
+  {
+    BufferPoolManagerInstance bpm(64, disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, transaction);
+    first_page_id = table.GetFirstPageId();
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+    }
+    num_pages = table.GetNumPages();
+    bpm.FlushAllPages();
+  }
+
+  auto time_scan = [&](TableHeap *table) {
+    double elapsed = 0;
+    for (int run = 0; run < 2; run++) {
+      int count = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+        count++;
+      }
+      elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      EXPECT_EQ(num_tuples, count);
+    }
+    return elapsed;
+  };
+  for (double table_to_pool : {8.0, 2.0, 1.0, 0.5}) {
+    BufferPoolManagerInstance bpm(static_cast<size_t>(num_pages / table_to_pool), disk_manager);
+    TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+    std::printf("[mapped scan] %zu pages, table %3.1fx the buffer pool: %7.2f ms\n", num_pages, table_to_pool,
+                time_scan(&table));
+  }
+  BufferPoolManagerInstance bpm(16, disk_manager);
+  TableHeap table(&bpm, lock_manager, log_manager, first_page_id);
+  std::unique_ptr<MappedPages> mapped_pages = disk_manager->MapPages();
+  table.SetMappedPages(mapped_pages.get());
+  std::printf("[mapped scan] %zu pages, mapped:                     %7.2f ms\n", num_pages, time_scan(&table));
+  table.SetMappedPages(nullptr);
+  mapped_pages.reset();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub